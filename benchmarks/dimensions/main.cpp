@@ -0,0 +1,215 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <array>
+#include <kot_motor/kot_motor.hpp>
+
+using namespace kot_motor;
+using Clock = std::chrono::steady_clock;
+
+// Cost of the dimensions, a PD law over arrays of motors:
+//   ./dimensions [motors] [rounds]
+// The same kernel is instantiated with raw floats, with units, with
+// units of double and of 32 bit fixed point. Floats and units
+// should run alike and compile to the same instructions but for the
+// choice of registers, which
+//   objdump -dC dimensions | grep -A40 'pdLaw<'
+// shows. The layout of the units is checked by dimensions.hpp itself.
+// The last rows run the law over the joints of one robot, JOINTS of
+// them, as a loop over floats and as UnitArray expressions.
+
+namespace {
+
+float clamp(float value, float lower, float upper)
+{
+  return std::min(std::max(value, lower), upper);
+}
+
+template <typename Dimensions, typename T>
+Unit<Dimensions, T> clamp(Unit<Dimensions, T> value, Unit<Dimensions, T> lower, Unit<Dimensions, T> upper)
+{
+  return limitUnitBy(value, lower, upper);
+}
+
+template <typename Position, typename Velocity, typename Stiffness, typename Damping, typename Torque>
+__attribute__((noinline)) void pdLaw(const Position * target,
+                                     const Position * position,
+                                     const Velocity * velocity,
+                                     Stiffness kp,
+                                     Damping kd,
+                                     Torque limit,
+                                     Torque * torque,
+                                     size_t motorsN)
+{
+  for (size_t i = 0; i < motorsN; i++) {
+    torque[i] = clamp(kp * (target[i] - position[i]) - kd * velocity[i], -limit, limit);
+  }
+}
+
+// a float as the raw float or as a unit of any scalar
+template <typename Value>
+Value from(float value)
+{
+  if constexpr (std::is_arithmetic_v<Value>) {
+    return Value(value);
+  } else {
+    return Value(typename Value::scalar(value));
+  }
+}
+
+template <typename Position, typename Velocity, typename Stiffness, typename Damping, typename Torque>
+double nsPerMotor(const std::vector<float> & values, size_t motorsN, size_t roundsN)
+{
+  std::vector<Position> target(motorsN);
+  std::vector<Position> position(motorsN);
+  std::vector<Velocity> velocity(motorsN);
+  std::vector<Torque> torque(motorsN);
+  for (size_t i = 0; i < motorsN; i++) {
+    target[i] = from<Position>(values[3 * i]);
+    position[i] = from<Position>(values[3 * i + 1]);
+    velocity[i] = from<Velocity>(values[3 * i + 2]);
+  }
+
+  float sink = 0.0f;
+  auto start = Clock::now();
+  for (size_t r = 0; r < roundsN; r++) {
+    pdLaw(target.data(), position.data(), velocity.data(), from<Stiffness>(20), from<Damping>(0.5f), from<Torque>(18), torque.data(), motorsN);
+    sink += float(torque[r % motorsN]);
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+  // keeps the loop from being optimized out
+  if (sink == 42.0f) {
+    std::cout << "";
+  }
+  return elapsed.count() / (roundsN * motorsN);
+}
+
+constexpr size_t JOINTS = 12;
+
+using Joints = UnitArray<Radian::dimension, JOINTS>;
+using JointVelocities = UnitArray<AngularVelocity::dimension, JOINTS>;
+using JointTorques = UnitArray<Torque::dimension, JOINTS>;
+
+__attribute__((noinline)) void pdLaw(const float * target,
+                                     const float * position,
+                                     const float * velocity,
+                                     float kp,
+                                     float kd,
+                                     float limit,
+                                     float * torque)
+{
+  for (size_t i = 0; i < JOINTS; i++) {
+    torque[i] = clamp(kp * (target[i] - position[i]) - kd * velocity[i], -limit, limit);
+  }
+}
+
+__attribute__((noinline)) void pdLaw(const Joints & target,
+                                     const Joints & position,
+                                     const JointVelocities & velocity,
+                                     RotationalStiffness kp,
+                                     RotationalDamping kd,
+                                     Torque limit,
+                                     JointTorques & torque)
+{
+  torque = limitUnitBy(kp * (target - position) - kd * velocity, -limit, limit);
+}
+
+template <typename Position, typename Velocity, typename Torque, typename... Gains>
+double nsPerRobot(const std::vector<float> & values, size_t roundsN, Gains... gains)
+{
+  Position target{};
+  Position position{};
+  Velocity velocity{};
+  Torque torque{};
+  for (size_t i = 0; i < JOINTS; i++) {
+    target[i] = values[3 * i];
+    position[i] = values[3 * i + 1];
+    velocity[i] = values[3 * i + 2];
+  }
+
+  float sink = 0.0f;
+  auto start = Clock::now();
+  for (size_t r = 0; r < roundsN; r++) {
+    pdLaw(target, position, velocity, gains..., torque);
+    sink += float(torque[r % JOINTS]);
+    position[r % JOINTS] = float(torque[r % JOINTS]);
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+  if (sink == 42.0f) {
+    std::cout << "";
+  }
+  return elapsed.count() / roundsN;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t motorsN = argc > 1 ? std::stoul(argv[1]) : 1024;
+  size_t roundsN = argc > 2 ? std::stoul(argv[2]) : 100000;
+
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> within(-10.0f, 10.0f);
+  std::vector<float> values(3 * motorsN);
+  for (auto && value : values) {
+    value = within(random);
+  }
+
+  double floatNs = nsPerMotor<float, float, float, float, float>(values, motorsN, roundsN);
+  double unitNs = nsPerMotor<Radian, AngularVelocity, RotationalStiffness, RotationalDamping, Torque>(
+    values, motorsN, roundsN
+  );
+  using Double = double;
+  double doubleNs = nsPerMotor<
+    WithScalar<Radian, Double>, WithScalar<AngularVelocity, Double>, WithScalar<RotationalStiffness, Double>,
+    WithScalar<RotationalDamping, Double>, WithScalar<Torque, Double>
+  >(values, motorsN, roundsN);
+  using Q16 = Fixed32<16>;
+  double fixedNs = nsPerMotor<
+    WithScalar<Radian, Q16>, WithScalar<AngularVelocity, Q16>, WithScalar<RotationalStiffness, Q16>,
+    WithScalar<RotationalDamping, Q16>, WithScalar<Torque, Q16>
+  >(values, motorsN, roundsN);
+
+  using Floats = std::array<float, JOINTS>;
+  auto floatRobotNs = [&] {
+    Floats target{};
+    Floats position{};
+    Floats velocity{};
+    Floats torque{};
+    for (size_t i = 0; i < JOINTS; i++) {
+      target[i] = values[3 * i];
+      position[i] = values[3 * i + 1];
+      velocity[i] = values[3 * i + 2];
+    }
+    float sink = 0.0f;
+    auto start = Clock::now();
+    for (size_t r = 0; r < roundsN; r++) {
+      pdLaw(target.data(), position.data(), velocity.data(), 20.0f, 0.5f, 18.0f, torque.data());
+      sink += torque[r % JOINTS];
+      position[r % JOINTS] = float(torque[r % JOINTS]);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+    if (sink == 42.0f) {
+      std::cout << "";
+    }
+    return elapsed.count() / roundsN;
+  }();
+  double arrayRobotNs = nsPerRobot<Joints, JointVelocities, JointTorques>(
+    values, roundsN, RotationalStiffness(20), RotationalDamping(0.5f), Torque(18)
+  );
+
+  std::cout << roundsN << " rounds of " << motorsN << " motors, ns per motor\n" << std::fixed << std::setprecision(3)
+            << std::left << std::setw(12) << "float" << floatNs << "\n"
+            << std::left << std::setw(12) << "units" << unitNs << "\n"
+            << std::left << std::setw(12) << "double" << doubleNs << "\n"
+            << std::left << std::setw(12) << "fixed" << fixedNs << "\n"
+            << "sizeof(Radian): " << sizeof(Radian) << "\n"
+            << roundsN << " rounds of " << JOINTS << " joints, ns per robot\n"
+            << std::left << std::setw(12) << "float" << floatRobotNs << "\n"
+            << std::left << std::setw(12) << "UnitArray" << arrayRobotNs << "\n";
+  return 0;
+}
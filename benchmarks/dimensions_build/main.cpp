@@ -0,0 +1,127 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+using Clock = std::chrono::steady_clock;
+
+// Compile time of the dimensions, a translation unit of unit expressions:
+//   ./dimensions_build [expressions] [repeats]
+// A source of as many functions, each multiplying and dividing a few
+// units of the library into a dimension of its own, is generated and
+// compiled with the compiler of the build, as is a source with the
+// header alone. Only the front end runs, the dimensions cost nothing
+// past the templates. The best time of the repeats and the peak memory
+// of the compiler are reported, the difference between the two sources
+// is the cost of the expressions.
+
+namespace {
+
+struct Compilation {
+  double ms = 0.0;
+  long maxRssKb = 0;
+  bool ok = false;
+};
+
+const std::vector<std::string> UNITS = {
+  "Meter", "Kg", "Second", "Amp", "Kelvin", "Radian", "Degree", "Velocity", "Accel", "AngularVelocity",
+  "AngularAccel", "Newton", "Torque", "RotationalStiffness", "RotationalDamping", "Watt", "Volt", "Hertz",
+};
+
+void generate(const std::string & path, size_t expressionsN)
+{
+  std::mt19937 random(1);
+  std::uniform_int_distribution<size_t> unit(0, UNITS.size() - 1);
+  std::uniform_int_distribution<int> factors(2, 6);
+  std::bernoulli_distribution divide(0.5);
+
+  std::ofstream source(path);
+  source << "#include \"dimensions/dimensions.hpp\"\n\n"
+         << "using namespace kot_motor::dimensions;\n\n";
+  for (size_t i = 0; i < expressionsN; i++) {
+    source << "float expression" << i << "(float x)\n{\n  auto u = " << UNITS[unit(random)] << "(x)";
+    for (int k = factors(random); k > 1; k--) {
+      source << (divide(random) ? " / " : " * ") << UNITS[unit(random)] << "(x)";
+    }
+    source << ";\n  return float(u + u * 2.0f);\n}\n\n";
+  }
+}
+
+Compilation compile(const std::string & path)
+{
+  Compilation compilation;
+  auto start = Clock::now();
+  pid_t pid = fork();
+  if (pid == 0) {
+    execl(KOT_CXX_COMPILER, KOT_CXX_COMPILER, "-std=c++17", "-fsyntax-only", "-I", KOT_SOURCE_DIR, path.c_str(),
+          static_cast<char *>(nullptr));
+    _exit(127);
+  }
+  if (pid < 0) {
+    return compilation;
+  }
+
+  int status = 0;
+  rusage usage = {};
+  if (wait4(pid, &status, 0, &usage) != pid) {
+    return compilation;
+  }
+  compilation.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  compilation.maxRssKb = usage.ru_maxrss;
+  compilation.ok = WIFEXITED(status) and WEXITSTATUS(status) == 0;
+  return compilation;
+}
+
+Compilation best(const std::string & path, size_t repeatsN)
+{
+  Compilation result;
+  for (size_t r = 0; r < repeatsN; r++) {
+    Compilation compilation = compile(path);
+    if (!compilation.ok) {
+      return compilation;
+    }
+    if (!result.ok or compilation.ms < result.ms) {
+      result = compilation;
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t expressionsN = argc > 1 ? std::stoul(argv[1]) : 2000;
+  size_t repeatsN = argc > 2 ? std::stoul(argv[2]) : 3;
+
+  std::string base = "/tmp/dimensions_build_" + std::to_string(getpid());
+  std::string headerPath = base + "_header.cpp";
+  std::string expressionsPath = base + "_expressions.cpp";
+  generate(headerPath, 0);
+  generate(expressionsPath, expressionsN);
+
+  Compilation header = best(headerPath, repeatsN);
+  Compilation expressions = best(expressionsPath, repeatsN);
+  unlink(headerPath.c_str());
+  unlink(expressionsPath.c_str());
+  if (!header.ok or !expressions.ok) {
+    std::cerr << "compiling with " << KOT_CXX_COMPILER << " failed\n";
+    return 1;
+  }
+
+  std::cout << KOT_CXX_COMPILER << ", best of " << repeatsN << ", ms and peak MB\n" << std::fixed
+            << std::setprecision(1) << std::left << std::setw(16) << "header" << std::setw(10) << header.ms
+            << header.maxRssKb / 1024.0 << "\n"
+            << std::left << std::setw(16) << (std::to_string(expressionsN) + " units") << std::setw(10)
+            << expressions.ms << expressions.maxRssKb / 1024.0 << "\n"
+            << "us per expression: " << std::setprecision(2)
+            << 1000.0 * (expressions.ms - header.ms) / std::max<size_t>(expressionsN, 1) << "\n";
+  return 0;
+}
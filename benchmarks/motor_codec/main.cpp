@@ -0,0 +1,275 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <kot_motor/kot_motor.hpp>
+
+using namespace kot_motor;
+using kot_motor::motor::MotorCodec;
+using Clock = std::chrono::steady_clock;
+
+// Per-frame cost of the MIT packing, then per-cycle cost of a robot:
+//   ./motor_codec [frames] [motors]
+// "reference" is the packing Motor had right before MotorCodec: each
+// field clamped again, then scaled by a division in double precision
+// behind a branch on its width. Its torque is decoded over [min, max],
+// as fixed along with the simulated transport, the original code took
+// [min, -max]. "codec" is MotorCodec configured at run time, "static"
+// is StaticCodec of the same model, with its scales folded. All of
+// them encode the same commands and decode the same replies, but for
+// a float scale rounding a value to the neighbouring code.
+// A cycle encodes the commands of all the motors and decodes a reply
+// of each, by a loop over MotorCodec or by a MotorGroup.
+// The frame loops are kept out of line, one per codec, and the runtime
+// codec is hidden from the optimizer, which would otherwise fold its
+// ranges as well, their difference is then the one of the folding:
+//   objdump -dC motor_codec | grep -A80 'nsPerFrame<.*StaticCodec'
+
+namespace {
+
+struct Reference {
+  Motor::MotorLimits limits;
+
+  static uint32_t floatToUint(float x, float x_min, float x_max, uint8_t bits)
+  {
+    float span = x_max - x_min;
+    float offset = x_min;
+    unsigned int pgg = 0;
+    if (bits == 12) {
+      pgg = (unsigned int)((x - offset) * 4095.0 / span);
+    } else if (bits == 16) {
+      pgg = (unsigned int)((x - offset) * 65535.0 / span);
+    }
+    return pgg;
+  }
+
+  static float uintToFloat(uint32_t x_int, float x_min, float x_max, uint8_t bits)
+  {
+    float span = x_max - x_min;
+    float offset = x_min;
+    float pgg = 0;
+    if (bits == 12) {
+      pgg = ((float)x_int) * span / 4095.0 + offset;
+    } else if (bits == 16) {
+      pgg = ((float)x_int) * span / 65535.0 + offset;
+    }
+    return pgg;
+  }
+
+  template <typename Unit, typename Limit>
+  static uint32_t field(float value, const Limit & limit, uint8_t bits)
+  {
+    Unit clamped = dimensions::limitUnitBy(Unit(value), limit.min, limit.max);
+    return floatToUint(float(clamped), float(limit.min), float(limit.max), bits);
+  }
+
+  void encode(const MotorCodec::Command & c, uint8_t * buff) const
+  {
+    uint32_t p_int = field<Radian>(c.position, limits.position, 16);
+    uint32_t v_int = field<AngularVelocity>(c.velocity, limits.velocity, 12);
+    uint32_t t_int = field<Torque>(c.torque, limits.torque, 12);
+    uint32_t kp_int = field<RotationalStiffness>(c.stiffness, limits.stiffness, 12);
+    uint32_t kd_int = field<RotationalDamping>(c.damper, limits.damper, 12);
+    buff[0] = p_int >> 8;
+    buff[1] = p_int & 0xFF;
+    buff[2] = v_int >> 4;
+    buff[3] = ((v_int & 0xF) << 4) | (kp_int >> 8);
+    buff[4] = kp_int & 0xFF;
+    buff[5] = kd_int >> 4;
+    buff[6] = ((kd_int & 0xF) << 4) | (t_int >> 8);
+    buff[7] = t_int & 0xFF;
+  }
+
+  MotorCodec::State decode(const uint8_t * data) const
+  {
+    uint32_t p_int = (data[1] << 8) | data[2];
+    uint32_t v_int = (data[3] << 4) | (data[4] >> 4);
+    uint32_t i_int = ((data[4] & 0xF) << 8) | data[5];
+    return MotorCodec::State{
+      uintToFloat(p_int, float(limits.position.min), float(limits.position.max), 16),
+      uintToFloat(v_int, float(limits.velocity.min), float(limits.velocity.max), 12),
+      uintToFloat(i_int, float(limits.torque.min), float(limits.torque.max), 12)
+    };
+  }
+};
+
+// the commands stay in the cache, only the packing is measured
+const size_t COMMANDS_N = 1024; // a power of 2
+
+// as if the value were read at run time, the configuration of a Motor is
+template <typename T>
+void opaque(T & value)
+{
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+template <typename Codec>
+__attribute__((noinline)) double nsPerFrame(const Codec & codec,
+                  const std::vector<MotorCodec::Command> & commands,
+                  std::vector<uint8_t> & wire,
+                  size_t framesN)
+{
+  float sink = 0.0f;
+  auto start = Clock::now();
+  for (size_t i = 0; i < framesN; i++) {
+    size_t k = i & (COMMANDS_N - 1);
+    uint8_t * data = &wire[k * 8];
+    codec.encode(commands[k], data);
+    MotorCodec::State state = codec.decode(data);
+    sink += state.position + state.velocity + state.torque;
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+  // keeps the loop from being optimized out
+  if (sink == 42.0f) {
+    std::cout << "";
+  }
+  return elapsed.count() / framesN;
+}
+
+// a cycle per MotorCodec, as a loop over Motor objects would pack
+double nsPerCycle(const MotorCodec & codec,
+                  const std::vector<MotorCodec::Command> & commands,
+                  const std::vector<BasicTransport::CanFrame> & replies,
+                  std::vector<BasicTransport::CanFrame> & frames,
+                  std::vector<MotorCodec::State> & states,
+                  size_t cyclesN)
+{
+  size_t motorsN = frames.size();
+  size_t cyclesPerTable = COMMANDS_N / motorsN;
+  auto start = Clock::now();
+  for (size_t c = 0; c < cyclesN; c++) {
+    const MotorCodec::Command * command = &commands[(c % cyclesPerTable) * motorsN];
+    for (size_t i = 0; i < motorsN; i++) {
+      frames[i].canId = i + 1;
+      frames[i].size = 8;
+      codec.encode(command[i], frames[i].data);
+    }
+    for (size_t i = 0; i < motorsN; i++) {
+      states[i] = codec.decode(replies[i].data);
+    }
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+  return elapsed.count() / cyclesN;
+}
+
+// a cycle per MotorGroup, the setpoints written as a controller would
+double nsPerCycle(MotorGroup & group,
+                  const std::vector<MotorCodec::Command> & commands,
+                  const std::vector<BasicTransport::CanFrame> & replies,
+                  std::vector<BasicTransport::CanFrame> & frames,
+                  size_t cyclesN)
+{
+  size_t motorsN = frames.size();
+  size_t cyclesPerTable = COMMANDS_N / motorsN;
+  float * positions = group.positions();
+  float * velocities = group.velocities();
+  float * stiffnesses = group.stiffnesses();
+  float * dampers = group.dampers();
+  float * torques = group.torques();
+  auto start = Clock::now();
+  for (size_t c = 0; c < cyclesN; c++) {
+    const MotorCodec::Command * command = &commands[(c % cyclesPerTable) * motorsN];
+    for (size_t i = 0; i < motorsN; i++) {
+      positions[i] = command[i].position;
+      velocities[i] = command[i].velocity;
+      stiffnesses[i] = command[i].stiffness;
+      dampers[i] = command[i].damper;
+      torques[i] = command[i].torque;
+    }
+    group.encode(frames.data());
+    group.decode(replies.data(), motorsN);
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start);
+  return elapsed.count() / cyclesN;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t framesN = argc > 1 ? std::stoul(argv[1]) : 100000000;
+  size_t motorsN = std::clamp<size_t>(argc > 2 ? std::stoul(argv[2]) : 12, 1, 255);
+  const Motor::MotorLimits & limits = config::default_motor.motorHwLimits;
+
+  std::mt19937 random(1);
+  auto within = [&](auto && limit) {
+    return std::uniform_real_distribution<float>(float(limit.min), float(limit.max))(random);
+  };
+  std::vector<MotorCodec::Command> commands(COMMANDS_N);
+  for (auto && command : commands) {
+    command = MotorCodec::Command{
+      within(limits.position), within(limits.velocity), within(limits.stiffness),
+      within(limits.damper), within(limits.torque)
+    };
+  }
+
+  Reference reference{limits};
+  MotorCodec codec(motor::codecRanges(limits));
+  opaque(codec);
+
+  std::vector<uint8_t> referenceWire(COMMANDS_N * 8);
+  std::vector<uint8_t> codecWire(COMMANDS_N * 8);
+  double referenceNs = nsPerFrame(reference, commands, referenceWire, framesN);
+  double codecNs = nsPerFrame(codec, commands, codecWire, framesN);
+  std::vector<uint8_t> staticWire(COMMANDS_N * 8);
+  double staticNs = nsPerFrame(StaticCodec<config::model::DefaultMotor>(), commands, staticWire, framesN);
+
+  // the float scales may round a value to the neighbouring code
+  size_t differing = 0;
+  for (size_t i = 0; i < referenceWire.size(); i++) {
+    differing += referenceWire[i] != codecWire[i];
+  }
+  bool sameStatic = staticWire == codecWire;
+
+  // replies of random states
+  std::vector<BasicTransport::CanFrame> replies(motorsN);
+  for (size_t i = 0; i < motorsN; i++) {
+    replies[i].canId = 0;
+    replies[i].size = 6;
+    replies[i].data[0] = i + 1;
+    for (size_t b = 1; b < 6; b++) {
+      replies[i].data[b] = random() & 0xFF;
+    }
+  }
+
+  MotorGroup group;
+  for (size_t i = 0; i < motorsN; i++) {
+    group.add(i + 1, motor::codecRanges(limits));
+  }
+
+  size_t cyclesN = framesN / motorsN;
+  std::vector<BasicTransport::CanFrame> codecFrames(motorsN);
+  std::vector<MotorCodec::State> codecStates(motorsN);
+  double codecCycleNs = nsPerCycle(codec, commands, replies, codecFrames, codecStates, cyclesN);
+  std::vector<BasicTransport::CanFrame> groupFrames(motorsN);
+  double groupCycleNs = nsPerCycle(group, commands, replies, groupFrames, cyclesN);
+
+  // a build with FMA may fuse the decoding of one of them
+  auto close = [](float a, float b) {
+    return std::abs(a - b) <= 1e-6f * std::max(1.0f, std::abs(b));
+  };
+  bool sameGroup = true;
+  for (size_t i = 0; i < motorsN; i++) {
+    sameGroup = sameGroup and groupFrames[i].canId == codecFrames[i].canId
+                and std::equal(groupFrames[i].data, groupFrames[i].data + 8, codecFrames[i].data)
+                and close(group.actualPositions()[i], codecStates[i].position)
+                and close(group.actualVelocities()[i], codecStates[i].velocity)
+                and close(group.actualTorques()[i], codecStates[i].torque);
+  }
+
+  std::cout << framesN << " frames, encode + decode, ns per frame\n" << std::fixed << std::setprecision(2)
+            << std::left << std::setw(12) << "reference" << referenceNs << "\n"
+            << std::left << std::setw(12) << "codec" << codecNs << "\n"
+            << std::left << std::setw(12) << "static" << staticNs << "\n"
+            << "bytes differing from the reference: " << differing << " of " << referenceWire.size() << "\n"
+            << "static same as codec: " << (sameStatic ? "yes" : "no") << "\n\n"
+            << cyclesN << " cycles of " << motorsN << " motors, encode + decode, ns per cycle\n"
+            << std::left << std::setw(12) << "codec" << codecCycleNs << "\n"
+            << std::left << std::setw(12) << "group" << groupCycleNs << "\n"
+            << "group same as codec: " << (sameGroup ? "yes" : "no") << "\n";
+  return 0;
+}
@@ -0,0 +1,166 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <sys/epoll.h>
+#include <kot_motor/kot_motor.hpp>
+
+using namespace kot_motor;
+using CanFrame = BasicTransport::CanFrame;
+using Clock = std::chrono::steady_clock;
+
+// Cycle latency of the transports on a virtual CAN bus:
+//   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+//   ./transport_vcan [vcan0] [frames per cycle] [cycles]
+// One socket sends a cycle of frames, another one on the same
+// interface receives them, the time until the last one came is measured.
+
+namespace {
+
+const auto TIMEOUT = std::chrono::microseconds(10000);
+
+struct Stats {
+  std::vector<double> us;
+  size_t lost = 0;
+};
+
+void print(const std::string & name, Stats & stats)
+{
+  std::sort(stats.us.begin(), stats.us.end());
+  double mean = 0.0;
+  for (double us : stats.us) {
+    mean += us;
+  }
+  mean /= std::max<size_t>(stats.us.size(), 1);
+
+  auto at = [&](double q) {
+    return stats.us.empty() ? 0.0 : stats.us[size_t(q * (stats.us.size() - 1))];
+  };
+
+  std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << mean
+            << std::setw(10) << at(0.5)
+            << std::setw(10) << at(0.99)
+            << std::setw(10) << at(1.0)
+            << std::setw(8) << stats.lost << "\n";
+}
+
+// Sends with the given function and receives on the given transport,
+// waiting through `wait`, until the whole cycle came back
+Stats run(size_t framesN, size_t cycles,
+          const std::function<size_t(const CanFrame *, size_t)> & send,
+          BasicTransport & receiver,
+          const std::function<bool(std::chrono::microseconds)> & wait)
+{
+  std::vector<CanFrame> frames(framesN);
+  for (size_t i = 0; i < framesN; i++) {
+    uint8_t data[8] = {uint8_t(i), 0x7f, 0xff, 0x7f, 0xf0, 0x00, 0x07, 0xff};
+    frames[i] = CanFrame(0x001, data);
+  }
+  std::vector<CanFrame> received(framesN);
+
+  Stats stats;
+  stats.us.reserve(cycles);
+  for (size_t c = 0; c < cycles; c++) {
+    auto start = Clock::now();
+    auto deadline = start + TIMEOUT;
+
+    size_t sent = send(frames.data(), framesN);
+    size_t got = 0;
+    while (got < sent and Clock::now() < deadline) {
+      got += receiver.readBatch(received.data(), framesN);
+      if (got < sent) {
+        wait(std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()));
+      }
+    }
+
+    if (got < framesN) {
+      stats.lost += framesN - got;
+      // the late frames must not leak into the next cycle
+      while (receiver.wait(TIMEOUT) and receiver.readBatch(received.data(), framesN) > 0) { }
+      continue;
+    }
+    stats.us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+  }
+  return stats;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  std::string ifname = argc > 1 ? argv[1] : "vcan0";
+  size_t framesN = argc > 2 ? std::stoul(argv[2]) : 12;
+  size_t cycles = argc > 3 ? std::stoul(argv[3]) : 10000;
+
+  std::cout << framesN << " frames per cycle, " << cycles << " cycles on " << ifname << ", us\n";
+  std::cout << std::left << std::setw(10) << "path" << std::right
+            << std::setw(10) << "mean" << std::setw(10) << "p50"
+            << std::setw(10) << "p99" << std::setw(10) << "max" << std::setw(8) << "lost" << "\n";
+
+  // a write per frame, ppoll to wait
+  {
+    SocketCanTransport tx(ifname), rx(ifname);
+    if (tx.open() != BasicTransport::Status::SUCCESS_INIT or rx.open() != BasicTransport::Status::SUCCESS_INIT) {
+      std::cerr << "can't open " << ifname << "\n";
+      return 1;
+    }
+    Stats stats = run(framesN, cycles,
+      [&](const CanFrame * frames, size_t count) {
+        size_t sent = 0;
+        while (sent < count and tx.write(frames[sent]) == BasicTransport::Status::SUCCESS) {
+          sent++;
+        }
+        return sent;
+      },
+      rx, [&](std::chrono::microseconds timeout) { return rx.wait(timeout); });
+    print("plain", stats);
+  }
+
+  // sendmmsg for the cycle, epoll to wait
+  {
+    SocketCanTransport tx(ifname), rx(ifname);
+    tx.open();
+    rx.open();
+    int epfd = epoll_create1(0);
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, rx.descriptor().value(), &event);
+
+    Stats stats = run(framesN, cycles,
+      [&](const CanFrame * frames, size_t count) { return tx.writeBatch(frames, count); },
+      rx, [&](std::chrono::microseconds timeout) {
+        struct epoll_event ready;
+        // epoll_wait can't wait for less than a millisecond
+        int ms = std::max<int>(1, std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count());
+        return epoll_wait(epfd, &ready, 1, ms) > 0;
+      });
+    ::close(epfd);
+    print("epoll", stats);
+  }
+
+  // one io_uring_enter for the cycle, the frames reaped from the ring
+  {
+    UringBusGroup group({ifname, ifname});
+    if (group.open() != BasicTransport::Status::SUCCESS_INIT) {
+      std::cerr << "io_uring isn't available\n";
+      return 1;
+    }
+    BasicTransport & tx = group.bus(0);
+    BasicTransport & rx = group.bus(1);
+
+    Stats stats = run(framesN, cycles,
+      [&](const CanFrame * frames, size_t count) {
+        group.beginCycle();
+        size_t queued = tx.writeBatch(frames, count);
+        return group.send() == BasicTransport::Status::SUCCESS ? queued : 0;
+      },
+      rx, [&](std::chrono::microseconds timeout) { return rx.wait(timeout); });
+    print("io_uring", stats);
+  }
+
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <csignal>
+#include <string>
+#include <thread>
+#include <kot_motor/kot_motor.hpp>
+
+using namespace kot_motor;
+
+// Owns a CAN bus and shares it with the other processes:
+//   ./motor_daemon [can0]
+// The clients open ShmTransport("/kot_motor_can0") and create their
+// Motor objects on it as on any other transport.
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int)
+{
+  stopRequested = 1;
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+  std::string ifname = argc > 1 ? argv[1] : "can0";
+
+  SocketCanTransport bus(ifname);
+  if (bus.open() != BasicTransport::Status::SUCCESS_INIT) {
+    std::cerr << "can't open " << ifname << "\n";
+    return 1;
+  }
+
+  ShmDaemon daemon(bus, "/kot_motor_" + ifname);
+  if (daemon.open() != BasicTransport::Status::SUCCESS_INIT) {
+    std::cerr << "can't create the shared memory segment\n";
+    return 1;
+  }
+
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  daemon.start();
+  std::cout << "serving " << ifname << "\n";
+
+  while (!stopRequested) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+
+  daemon.stop();
+  daemon.close();
+  return 0;
+}
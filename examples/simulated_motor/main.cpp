@@ -0,0 +1,45 @@
+#include <iostream>
+#include <chrono>
+#include <kot_motor/kot_motor.hpp>
+
+using namespace kot_motor;
+using namespace kot_motor::dimensions::literals;
+
+// 10 seconds of a 1 kHz position loop against a simulated motor,
+// runs as fast as the machine allows
+int main() {
+  SimulatedMotorTransport::Options options;
+  options.latency = std::chrono::microseconds(200);
+  options.dropRate = 0.01;
+
+  SimulatedMotorTransport t(options);
+  t.addMotor(3, 0, config::default_motor.motorHwLimits);
+  Motor m(t, 3, 0, config::default_motor);
+
+  m.enterMotorMode();
+  m.stiffness(20);
+  m.damper(1);
+  m.position(1.0_rad);
+
+  const auto period = std::chrono::microseconds(1000);
+  const int cycles = 10000;
+  int replies = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < cycles; i++) {
+    auto cycleStart = t.now();
+    m.sendToMotor();
+    t.wait(period);
+    if (m.getActualParameters() == BasicTransport::Status::SUCCESS) {
+      replies++;
+    }
+    t.advance(period - (t.now() - cycleStart));
+  }
+  auto wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+  std::cout << "replies: " << replies << "/" << cycles << "\n";
+  std::cout << "position: " << float(m.actualPosition()) << " rad\n";
+  std::cout << "simulated 10 s in " << wall.count() << " s\n";
+
+  return 0;
+}
@@ -1,19 +1,46 @@
 #ifndef KOT_MOTOR_HPP
 #define KOT_MOTOR_HPP
 
+#include "src/dimensions/unit_array.hpp"
 #include "src/motor/configs.hpp"
 #include "src/motor/motor.hpp"
+#include "src/motor/motor_cycle.hpp"
+#include "src/motor/motor_group.hpp"
+#include "src/motor/static_codec.hpp"
 #include "src/controllers/direct_position.hpp"
 #include "src/controllers/direct_velocity.hpp"
 #include "src/controllers/direct_torque.hpp"
 #include "src/controllers/velocity_accel.hpp"
 #include "src/controllers/position_step.hpp"
+#include "src/transport/bus_load.hpp"
 #include "src/transport/socketcan_transport.hpp"
+#include "src/transport/io_engine.hpp"
+#include "src/transport/bus_group.hpp"
+#include "src/transport/uring_bus_group.hpp"
+#include "src/transport/simulated_motor_transport.hpp"
+#include "src/transport/recording_transport.hpp"
+#include "src/transport/replay_transport.hpp"
+#include "src/transport/shm_daemon.hpp"
+#include "src/transport/shm_transport.hpp"
 
 namespace kot_motor {
 
 using kot_motor::motor::Motor;
+using kot_motor::motor::MotorCycle;
+using kot_motor::motor::MotorGroup;
+using kot_motor::motor::MotorCodec;
+using kot_motor::motor::StaticCodec;
 using kot_motor::transport::SocketCanTransport;
+using kot_motor::transport::IoEngine;
+using kot_motor::transport::BusGroup;
+using kot_motor::transport::UringBusGroup;
+using kot_motor::transport::SimulatedMotorTransport;
+using kot_motor::transport::RecordingTransport;
+using kot_motor::transport::ReplayTransport;
+using kot_motor::transport::ShmDaemon;
+using kot_motor::transport::ShmTransport;
+using kot_motor::transport::BasicTransport;
+using kot_motor::transport::BusLoad;
 using namespace kot_motor::dimensions;
 using namespace kot_motor::controller;
 
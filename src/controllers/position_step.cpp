@@ -1,4 +1,5 @@
 #include "position_step.hpp"
+#include <algorithm>
 #include <thread>
 #include <chrono>
 
@@ -94,8 +95,9 @@ PositionStepController::Status
   }
 
   /************************ movement *************************/
-  const float k_error = 1.1;
-  const Time one_sending_time = 1.0 / 1000000.0 * k_error;
+  // bus time of a command and its reply
+  const Time one_sending_time =
+    std::chrono::duration<float>(motor.transport().frameTime()).count();
   Radian acceptable_pos_error = deg_to_rad(0.01);
 
   Radian delta = desPos - actPos;
@@ -103,7 +105,7 @@ PositionStepController::Status
   uint32_t stepsN = std::abs(float(delta) / float(step));
   Radian pos_error = float(delta) - float(step) * stepsN;
   Time total_t = (stepsN / float(freq)) - (stepsN * float(one_sending_time));
-  uint32_t delay_between_sendings_us = 1000000 * int(total_t) / stepsN;
+  uint32_t delay_between_sendings_us = 1000000 * std::max(0.0f, float(total_t)) / stepsN;
 
   BasicTransport::Status status = BasicTransport::Status::SUCCESS;
   if (direction == Direction::RIGHT) {
@@ -1,5 +1,6 @@
 #include "velocity_accel.hpp"
 #include <string>
+#include <algorithm>
 #include <thread>
 #include <chrono>
 
@@ -135,15 +136,14 @@ VelocityAccelController::Status
     return v0 + accel * t;
   };
 
-  // based on the top mcp2515 frequency
-  const float k_error = 1.1;
-  const Time one_sending_time = 0.0002 * k_error;
+  // bus time of a command and its reply
+  const Time one_sending_time =
+    std::chrono::duration<float>(motor.transport().frameTime()).count();
 
   Time delta_t = (v1 - v0) / accel; // in sec
   uint32_t sendings_n = float(delta_t) * float(freq);
   uint32_t delay_between_sendings_us =
-    1000000 * (float(delta_t) / sendings_n) -
-    (float(one_sending_time) * sendings_n);
+    1000000 * std::max(0.0f, float(delta_t) / sendings_n - float(one_sending_time));
 
   Status status = Status::SUCCESS;
   for (uint32_t i = 1; i <= sendings_n; i++) {
@@ -2,24 +2,24 @@
 #define DIMENSIONS_HPP
 
 #include "meta.hpp"
+#include "fixed.hpp"
 #include <algorithm>
+#include <type_traits>
 
 namespace kot_motor::dimensions {
 
 using namespace meta;
 
-class BasicUnit;
-
-template <typename SetDimensions>
+template <typename SetDimensions, typename T = float>
 class Unit;
 
-template <typename Dimensions1, typename Dimensions2>
+template <typename Dimensions1, typename Dimensions2, typename T = float>
 using MultipyingResultingType =
-  Unit<typename Transform<Dimensions1, Dimensions2, Plus>::type>;
+  Unit<typename Sum<Dimensions1, Dimensions2>::type, T>;
 
-template <typename Dimensions1, typename Dimensions2>
+template <typename Dimensions1, typename Dimensions2, typename T = float>
 using DivisionResultingType =
-  Unit<typename Transform<Dimensions1, Dimensions2, Minus>::type>;
+  Unit<typename Difference<Dimensions1, Dimensions2>::type, T>;
 
 /**************************** Dimension implementation ****************************/
 
@@ -49,424 +49,428 @@ using Mol = Unit<Dimension<0, 0, 0, 0, 0, 0, 1>>;
 using Rad = Unit<Dimension<0, 0, 0, 0, 0, 0, 0, 1>>;
 using Deg = Unit<Dimension<0, 0, 0, 0, 0, 0, 0, 0, 1>>;
 
-class BasicUnit {
-public:
-  virtual float value() const = 0;
-  virtual float & value() = 0;
-  virtual void value(float) = 0;
-
-  virtual ~BasicUnit() { }
-};
-
-template <typename SetDimensions>
-class Unit : public BasicUnit {
+// A value with its dimension in the type, as cheap as the scalar it
+// holds: no vtable, trivially copyable, usable in constant expressions.
+// The scalar is float unless said otherwise, double for long horizons,
+// Fixed to stay in integers. Units of different scalars don't mix, one
+// converts into the other explicitly.
+template <typename SetDimensions, typename T>
+class Unit {
 private:
-  float val;
+  T val;
 
 public:
   using dimension = SetDimensions;
+  using scalar = T;
 
-  Unit(float value)
+  constexpr Unit(T value)
     : val(value)
   { }
 
-  Unit()
+  constexpr Unit()
     : val(0)
   { }
 
-  Unit(const Unit &) = default;
-  Unit(Unit &&) = default;
-  Unit & operator=(const Unit &) = default;
-  Unit & operator=(Unit &&) = default;
-
-  float value() const override
+  template <typename U, typename = std::enable_if_t<!std::is_same_v<U, T>>>
+  constexpr explicit Unit(const Unit<SetDimensions, U> & other)
+    : val(static_cast<T>(other.value()))
   {
-    return this->val;
+    static_assert(std::is_constructible_v<T, U>, "no conversion between the scalars");
   }
 
-  float & value() override
+  constexpr T value() const
   {
     return this->val;
   }
 
-  void value(float val) override
-  {
-    this->val = val;
-  }
-
-  explicit operator int() const
-  {
-    return val;
-  }
-
-  explicit operator float() const
-  {
-    return val;
-  }
-
-  Unit operator+() const
-  {
-    return val;
-  }
-
-  Unit operator-() const
-  {
-    return -val;
-  }
-
-  Unit & operator+=(float x)
-  {
-    val += x;
-    return *this;
-  }
-
-  Unit & operator-=(float x)
-  {
-    val -= x;
-    return *this;
-  }
-
-  Unit & operator+=(const Unit & other)
+  constexpr T & value()
   {
-    val += other.val;
-    return *this;
+    return this->val;
   }
 
-  Unit & operator-=(const Unit & other)
+  constexpr void value(T val)
   {
-    val -= other.val;
-    return *this;
+    this->val = val;
   }
 
-  Unit & operator*=(float x)
+  constexpr explicit operator int() const
   {
-    val *= x;
-    return *this;
+    return static_cast<int>(val);
   }
 
-  Unit & operator/=(float x)
+  constexpr explicit operator float() const
   {
-    val /= x;
-    return *this;
+    return static_cast<float>(val);
   }
+};
 
-  /*********************** '+' and '-' between Dimension **************************/
-  template <typename Dimensions>
-  friend Unit<Dimensions>
-    operator+(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs);
-
-  template <typename Dimensions>
-  friend Unit<Dimensions>
-    operator-(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs);
+// The unit with the dimension of SomeUnit and the scalar T:
+//   WithScalar<AngularVelocity, double>
+template <typename SomeUnit, typename T>
+using WithScalar = Unit<typename SomeUnit::dimension, T>;
 
-  /*********************** '*' and '/' between Dimension **************************/
-  template <typename Dimensions1, typename Dimensions2>
-  friend MultipyingResultingType<Dimensions1, Dimensions2>
-    operator*(const Unit<Dimensions1> & lhs, const Unit<Dimensions2> & rhs);
+/******************** unary and compound assignment operators *********************/
+// free rather than members: a unit type only instantiates the ones it uses
 
-  template <typename Dimensions1, typename Dimensions2>
-  friend DivisionResultingType<Dimensions1, Dimensions2>
-    operator/(const Unit<Dimensions1> & lhs, const Unit<Dimensions2> & rhs);
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> operator+(const Unit<Dimensions, T> & unit)
+{
+  return unit;
+}
 
-  /****************** '*' and '/' between Dimension and numbers *******************/
-  template <typename Dimensions>
-  friend Unit<Dimensions> operator*(const Unit<Dimensions> & unit, float k);
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> operator-(const Unit<Dimensions, T> & unit)
+{
+  return Unit<Dimensions, T>(-unit.value());
+}
 
-  template <typename Dimensions>
-  friend Unit<Dimensions> operator/(const Unit<Dimensions> & unit, float k);
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> & operator+=(Unit<Dimensions, T> & unit, const Unit<Dimensions, T> & other)
+{
+  unit.value() += other.value();
+  return unit;
+}
 
-  template <typename Dimensions>
-  friend Unit<Dimensions> operator*(float k, const Unit<Dimensions> & unit);
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> & operator-=(Unit<Dimensions, T> & unit, const Unit<Dimensions, T> & other)
+{
+  unit.value() -= other.value();
+  return unit;
+}
 
-  template <typename Dimensions>
-  friend Unit<typename Transform<Dimension<>, Dimensions, Minus>::type>
-    operator/(float k, const Unit<Dimensions> & unit);
-};
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> & operator+=(Unit<Dimensions, T> & unit, typename Unit<Dimensions, T>::scalar x)
+{
+  unit.value() += x;
+  return unit;
+}
 
-/************************ derived user-defined dimensions **************************/
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> & operator-=(Unit<Dimensions, T> & unit, typename Unit<Dimensions, T>::scalar x)
+{
+  unit.value() -= x;
+  return unit;
+}
 
-using Velocity = decltype(Meter(1) / Second(1));
-using Accel = decltype(Meter(1) / (Second(1) * Second(1)));
-using AngularVelocity = decltype(Rad(1) / Second(1));
-using AngularAccel = decltype(Rad(1) / (Second(1) * Second(1)));
-using Newton = decltype(Meter(1) * Kg(1) / (Second(1) * Second(1)));
-using NewtonMeter = decltype(Newton(1) * Meter(1));
-using TranslationalStiffness = decltype(Newton(1) / Meter(1));
-using RotationalStiffness = decltype(NewtonMeter(1) / Rad(1));
-using TranslationalDamping = decltype(Newton(1) * Second(1) / Meter(1));
-using RotationalDamping = decltype(NewtonMeter(1) * Second(1) / Rad(1));
-using Watt = decltype(NewtonMeter(1) / Second(1));
-using Volt = decltype(Watt(1) / Amp(1));
-using Ohm = decltype(Volt(1) / Amp(1));
-using Hertz = decltype(1 / Second(1));
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> & operator*=(Unit<Dimensions, T> & unit, typename Unit<Dimensions, T>::scalar x)
+{
+  unit.value() *= x;
+  return unit;
+}
 
-/*********** alternative naming ***********/
-using Percent = Number;
-using Length = Meter;
-using Mass = Kg;
-using Weight = Mass;
-using Time = Second;
-using Ampere = Amp;
-using Current = Amp;
-using Temperature = Kelvin;
-using Light = Candela;
-using Concentration = Mol;
-using Radian = Rad;
-using Degree = Deg;
-using Force = Newton;
-using Torque = NewtonMeter;
-using FeedForwardTorque = NewtonMeter;
-using Joule = NewtonMeter;
-using Energy = Joule;
-using Work = Joule;
-using Voltage = Volt;
-using Resistance = Ohm;
-using Frequency = Hertz;
-using Hz = Hertz;
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> & operator/=(Unit<Dimensions, T> & unit, typename Unit<Dimensions, T>::scalar x)
+{
+  unit.value() /= x;
+  return unit;
+}
 
 /************ '==', '!=', '>', '<', '>=' and '<=' between Dimension ***************/
 
-template <typename Dimensions>
-bool operator==(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs)
+template <typename Dimensions, typename T>
+constexpr bool operator==(const Unit<Dimensions, T> & lhs, const Unit<Dimensions, T> & rhs)
 {
   return lhs.value() == rhs.value();
 }
 
-template <typename Dimensions>
-bool operator!=(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs)
+template <typename Dimensions, typename T>
+constexpr bool operator!=(const Unit<Dimensions, T> & lhs, const Unit<Dimensions, T> & rhs)
 {
   return !(lhs == rhs);
 }
 
-template <typename Dimensions>
-bool operator>(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs)
+template <typename Dimensions, typename T>
+constexpr bool operator>(const Unit<Dimensions, T> & lhs, const Unit<Dimensions, T> & rhs)
 {
   return lhs.value() > rhs.value();
 }
 
-template <typename Dimensions>
-bool operator<(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs)
+template <typename Dimensions, typename T>
+constexpr bool operator<(const Unit<Dimensions, T> & lhs, const Unit<Dimensions, T> & rhs)
 {
   return rhs > lhs;
 }
 
-template <typename Dimensions>
-bool operator>=(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs)
+template <typename Dimensions, typename T>
+constexpr bool operator>=(const Unit<Dimensions, T> & lhs, const Unit<Dimensions, T> & rhs)
 {
   return !(lhs < rhs);
 }
 
-template <typename Dimensions>
-bool operator<=(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs)
+template <typename Dimensions, typename T>
+constexpr bool operator<=(const Unit<Dimensions, T> & lhs, const Unit<Dimensions, T> & rhs)
 {
-  return !(lhs > lhs);
+  return !(lhs > rhs);
 }
 
 /************************ '+' and '-' between Dimension ***************************/
 
-template <typename Dimensions>
-Unit<Dimensions>
-  operator+(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs)
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T>
+  operator+(const Unit<Dimensions, T> & lhs, const Unit<Dimensions, T> & rhs)
 {
-  return Unit<Dimensions>(lhs.val + rhs.val);
+  return Unit<Dimensions, T>(lhs.value() + rhs.value());
 }
 
-template <typename Dimensions>
-Unit<Dimensions>
-  operator-(const Unit<Dimensions> & lhs, const Unit<Dimensions> & rhs)
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T>
+  operator-(const Unit<Dimensions, T> & lhs, const Unit<Dimensions, T> & rhs)
 {
-  return Unit<Dimensions>(lhs.val - rhs.val);
+  return Unit<Dimensions, T>(lhs.value() - rhs.value());
 }
 
 /************************ '*' and '/' between Dimension ***************************/
 
-template <typename Dimensions1, typename Dimensions2>
-MultipyingResultingType<Dimensions1, Dimensions2>
-  operator*(const Unit<Dimensions1> & lhs, const Unit<Dimensions2> & rhs)
+template <typename Dimensions1, typename Dimensions2, typename T>
+constexpr MultipyingResultingType<Dimensions1, Dimensions2, T>
+  operator*(const Unit<Dimensions1, T> & lhs, const Unit<Dimensions2, T> & rhs)
 {
-  return MultipyingResultingType<Dimensions1, Dimensions2>(lhs.val * rhs.val);
+  return MultipyingResultingType<Dimensions1, Dimensions2, T>(lhs.value() * rhs.value());
 }
 
-template <typename Dimensions1, typename Dimensions2>
-DivisionResultingType<Dimensions1, Dimensions2>
-  operator/(const Unit<Dimensions1> & lhs, const Unit<Dimensions2> & rhs)
+template <typename Dimensions1, typename Dimensions2, typename T>
+constexpr DivisionResultingType<Dimensions1, Dimensions2, T>
+  operator/(const Unit<Dimensions1, T> & lhs, const Unit<Dimensions2, T> & rhs)
 {
-  return DivisionResultingType<Dimensions1, Dimensions2>(lhs.val / rhs.val);
+  return DivisionResultingType<Dimensions1, Dimensions2, T>(lhs.value() / rhs.value());
 }
 
 /******************* '*' and '/' between Dimension and numbers ********************/
+// the number converts to the scalar of the unit as it would on its own
 
-template <typename Dimensions>
-Unit<Dimensions> operator*(const Unit<Dimensions> & unit, float k)
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T>
+  operator*(const Unit<Dimensions, T> & unit, typename Unit<Dimensions, T>::scalar k)
 {
-  return Unit<Dimensions>(unit.val * k);
+  return Unit<Dimensions, T>(unit.value() * k);
 }
 
-template <typename Dimensions>
-Unit<Dimensions> operator/(const Unit<Dimensions> & unit, float k)
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T>
+  operator/(const Unit<Dimensions, T> & unit, typename Unit<Dimensions, T>::scalar k)
 {
-  return Unit<Dimensions>(unit.val / k);
+  return Unit<Dimensions, T>(unit.value() / k);
 }
 
-template <typename Dimensions>
-Unit<Dimensions> operator*(float k, const Unit<Dimensions> & unit)
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T>
+  operator*(typename Unit<Dimensions, T>::scalar k, const Unit<Dimensions, T> & unit)
 {
-  return Unit<Dimensions>(unit.val * k);
+  return Unit<Dimensions, T>(unit.value() * k);
 }
 
-template <typename Dimensions>
-Unit<typename Transform<Dimension<>, Dimensions, Minus>::type>
-  operator/(float k, const Unit<Dimensions> & unit)
+template <typename Dimensions, typename T>
+constexpr Unit<typename Difference<Dimension<>, Dimensions>::type, T>
+  operator/(typename Unit<Dimensions, T>::scalar k, const Unit<Dimensions, T> & unit)
 {
-  return Unit<typename Transform<Dimension<>, Dimensions, Minus>::type>(
-    k / unit.val
+  return Unit<typename Difference<Dimension<>, Dimensions>::type, T>(
+    k / unit.value()
   );
 }
 
+/************************ derived user-defined dimensions **************************/
+
+// The product and the quotient of two units as types, with no operator
+// call to resolve for each of them
+template <typename Unit1, typename Unit2>
+using UnitProduct = MultipyingResultingType<typename Unit1::dimension, typename Unit2::dimension, typename Unit1::scalar>;
+
+template <typename Unit1, typename Unit2>
+using UnitQuotient = DivisionResultingType<typename Unit1::dimension, typename Unit2::dimension, typename Unit1::scalar>;
+
+using Velocity = UnitQuotient<Meter, Second>;
+using Accel = UnitQuotient<Velocity, Second>;
+using AngularVelocity = UnitQuotient<Rad, Second>;
+using AngularAccel = UnitQuotient<AngularVelocity, Second>;
+using Newton = UnitProduct<Kg, Accel>;
+using NewtonMeter = UnitProduct<Newton, Meter>;
+using TranslationalStiffness = UnitQuotient<Newton, Meter>;
+using RotationalStiffness = UnitQuotient<NewtonMeter, Rad>;
+using TranslationalDamping = UnitQuotient<UnitProduct<Newton, Second>, Meter>;
+using RotationalDamping = UnitQuotient<UnitProduct<NewtonMeter, Second>, Rad>;
+using Watt = UnitQuotient<NewtonMeter, Second>;
+using Volt = UnitQuotient<Watt, Amp>;
+using Ohm = UnitQuotient<Volt, Amp>;
+using Hertz = UnitQuotient<Number, Second>;
+
+/*********** alternative naming ***********/
+using Percent = Number;
+using Length = Meter;
+using Mass = Kg;
+using Weight = Mass;
+using Time = Second;
+using Ampere = Amp;
+using Current = Amp;
+using Temperature = Kelvin;
+using Light = Candela;
+using Concentration = Mol;
+using Radian = Rad;
+using Degree = Deg;
+using Force = Newton;
+using Torque = NewtonMeter;
+using FeedForwardTorque = NewtonMeter;
+using Joule = NewtonMeter;
+using Energy = Joule;
+using Work = Joule;
+using Voltage = Volt;
+using Resistance = Ohm;
+using Frequency = Hertz;
+using Hz = Hertz;
+
 /****************************** user-defined literals ******************************/
 
 namespace literals {
 
 // fundamental dimensions
-Meter operator""_m(long double val);
-Meter operator""_m(unsigned long long int val);
+constexpr Meter operator""_m(long double val) { return float(val); }
+constexpr Meter operator""_m(unsigned long long int val) { return float(val); }
 
-Kg operator""_kg(long double val);
-Kg operator""_kg(unsigned long long int val);
+constexpr Kg operator""_kg(long double val) { return float(val); }
+constexpr Kg operator""_kg(unsigned long long int val) { return float(val); }
 
-Second operator""_s(long double val);
-Second operator""_s(unsigned long long int val);
+constexpr Second operator""_s(long double val) { return float(val); }
+constexpr Second operator""_s(unsigned long long int val) { return float(val); }
 
-Amp operator""_A(long double val);
-Amp operator""_A(unsigned long long int val);
+constexpr Amp operator""_A(long double val) { return float(val); }
+constexpr Amp operator""_A(unsigned long long int val) { return float(val); }
 
-Kelvin operator""_K(long double val);
-Kelvin operator""_K(unsigned long long int val);
+constexpr Kelvin operator""_K(long double val) { return float(val); }
+constexpr Kelvin operator""_K(unsigned long long int val) { return float(val); }
 
-Candela operator""_cd(long double val);
-Candela operator""_cd(unsigned long long int val);
+constexpr Candela operator""_cd(long double val) { return float(val); }
+constexpr Candela operator""_cd(unsigned long long int val) { return float(val); }
 
-Mol operator""_mol(long double val);
-Mol operator""_mol(unsigned long long int val);
+constexpr Mol operator""_mol(long double val) { return float(val); }
+constexpr Mol operator""_mol(unsigned long long int val) { return float(val); }
 
-Rad operator""_rad(long double val);
-Rad operator""_rad(unsigned long long int val);
+constexpr Rad operator""_rad(long double val) { return float(val); }
+constexpr Rad operator""_rad(unsigned long long int val) { return float(val); }
 
-Deg operator""_deg(long double val);
-Deg operator""_deg(unsigned long long int val);
+constexpr Deg operator""_deg(long double val) { return float(val); }
+constexpr Deg operator""_deg(unsigned long long int val) { return float(val); }
 
 // derived measurements
-Velocity operator""_m_per_s(long double val);
-Velocity operator""_m_per_s(unsigned long long int val);
+constexpr Velocity operator""_m_per_s(long double val) { return float(val); }
+constexpr Velocity operator""_m_per_s(unsigned long long int val) { return float(val); }
 
-Accel operator""_m_per_s2(long double val);
-Accel operator""_m_per_s2(unsigned long long int val);
+constexpr Accel operator""_m_per_s2(long double val) { return float(val); }
+constexpr Accel operator""_m_per_s2(unsigned long long int val) { return float(val); }
 
-Newton operator""_N(long double val);
-Newton operator""_N(unsigned long long int val);
+constexpr Newton operator""_N(long double val) { return float(val); }
+constexpr Newton operator""_N(unsigned long long int val) { return float(val); }
 
-Joule operator""_J(long double val);
-Joule operator""_J(unsigned long long int val);
+constexpr Joule operator""_J(long double val) { return float(val); }
+constexpr Joule operator""_J(unsigned long long int val) { return float(val); }
 
-Joule operator""_joule(long double val);
-Joule operator""_joule(unsigned long long int val);
+constexpr Joule operator""_joule(long double val) { return float(val); }
+constexpr Joule operator""_joule(unsigned long long int val) { return float(val); }
 
 // alternative naming
-Percent operator""_percent(long double val);
-Percent operator""_percent(unsigned long long int val);
+constexpr Percent operator""_percent(long double val) { return float(val); }
+constexpr Percent operator""_percent(unsigned long long int val) { return float(val); }
 
-Percent operator""_pct(long double val);
-Percent operator""_pct(unsigned long long int val);
+constexpr Percent operator""_pct(long double val) { return float(val); }
+constexpr Percent operator""_pct(unsigned long long int val) { return float(val); }
 
-Length operator""_length(long double val);
-Length operator""_length(unsigned long long int val);
+constexpr Length operator""_length(long double val) { return float(val); }
+constexpr Length operator""_length(unsigned long long int val) { return float(val); }
 
-Mass operator""_mass(long double val);
-Mass operator""_mass(unsigned long long int val);
+constexpr Mass operator""_mass(long double val) { return float(val); }
+constexpr Mass operator""_mass(unsigned long long int val) { return float(val); }
 
-Time operator""_time(long double val);
-Time operator""_time(unsigned long long int val);
+constexpr Time operator""_time(long double val) { return float(val); }
+constexpr Time operator""_time(unsigned long long int val) { return float(val); }
 
-Ampere operator""_amps(long double val);
-Ampere operator""_amps(unsigned long long int val);
+constexpr Ampere operator""_amps(long double val) { return float(val); }
+constexpr Ampere operator""_amps(unsigned long long int val) { return float(val); }
 
-Current operator""_current(long double val);
-Current operator""_current(unsigned long long int val);
+constexpr Current operator""_current(long double val) { return float(val); }
+constexpr Current operator""_current(unsigned long long int val) { return float(val); }
 
-Temperature operator""_temp(long double val);
-Temperature operator""_temp(unsigned long long int val);
+constexpr Temperature operator""_temp(long double val) { return float(val); }
+constexpr Temperature operator""_temp(unsigned long long int val) { return float(val); }
 
-Light operator""_light(long double val);
-Light operator""_light(unsigned long long int val);
+constexpr Light operator""_light(long double val) { return float(val); }
+constexpr Light operator""_light(unsigned long long int val) { return float(val); }
 
-Concentration operator""_concentration(long double val);
-Concentration operator""_concentration(unsigned long long int val);
+constexpr Concentration operator""_concentration(long double val) { return float(val); }
+constexpr Concentration operator""_concentration(unsigned long long int val) { return float(val); }
 
-Radian operator""_radians(long double val);
-Radian operator""_radians(unsigned long long int val);
+constexpr Radian operator""_radians(long double val) { return float(val); }
+constexpr Radian operator""_radians(unsigned long long int val) { return float(val); }
 
-Degree operator""_degree(long double val);
-Degree operator""_degree(unsigned long long int val);
+constexpr Degree operator""_degree(long double val) { return float(val); }
+constexpr Degree operator""_degree(unsigned long long int val) { return float(val); }
 
-Energy operator""_energy(long double val);
-Energy operator""_energy(unsigned long long int val);
+constexpr Energy operator""_energy(long double val) { return float(val); }
+constexpr Energy operator""_energy(unsigned long long int val) { return float(val); }
 
-NewtonMeter operator""_Nm(long double val);
-NewtonMeter operator""_Nm(unsigned long long int val);
+constexpr NewtonMeter operator""_Nm(long double val) { return float(val); }
+constexpr NewtonMeter operator""_Nm(unsigned long long int val) { return float(val); }
 
-Torque operator""_torq(long double val);
-Torque operator""_torq(unsigned long long int val);
+constexpr Torque operator""_torq(long double val) { return float(val); }
+constexpr Torque operator""_torq(unsigned long long int val) { return float(val); }
 
-Force operator""_force(long double val);
-Force operator""_force(unsigned long long int val);
+constexpr Force operator""_force(long double val) { return float(val); }
+constexpr Force operator""_force(unsigned long long int val) { return float(val); }
 
-TranslationalStiffness operator""_ts(long double val);
-TranslationalStiffness operator""_ts(unsigned long long int val);
+constexpr TranslationalStiffness operator""_ts(long double val) { return float(val); }
+constexpr TranslationalStiffness operator""_ts(unsigned long long int val) { return float(val); }
 
-RotationalStiffness operator""_rs(long double val);
-RotationalStiffness operator""_rs(unsigned long long int val);
+constexpr RotationalStiffness operator""_rs(long double val) { return float(val); }
+constexpr RotationalStiffness operator""_rs(unsigned long long int val) { return float(val); }
 
-TranslationalDamping operator""_td(long double val);
-TranslationalDamping operator""_td(unsigned long long int val);
+constexpr TranslationalDamping operator""_td(long double val) { return float(val); }
+constexpr TranslationalDamping operator""_td(unsigned long long int val) { return float(val); }
 
-RotationalDamping operator""_rd(long double val);
-RotationalDamping operator""_rd(unsigned long long int val);
+constexpr RotationalDamping operator""_rd(long double val) { return float(val); }
+constexpr RotationalDamping operator""_rd(unsigned long long int val) { return float(val); }
 
-AngularVelocity operator""_av(long double val);
-AngularVelocity operator""_av(unsigned long long int val);
+constexpr AngularVelocity operator""_av(long double val) { return float(val); }
+constexpr AngularVelocity operator""_av(unsigned long long int val) { return float(val); }
 
-Work operator""_work(long double val);
-Work operator""_work(unsigned long long int val);
+constexpr Work operator""_work(long double val) { return float(val); }
+constexpr Work operator""_work(unsigned long long int val) { return float(val); }
 
-Voltage operator""_voltage(long double val);
-Voltage operator""_voltage(unsigned long long int val);
+constexpr Voltage operator""_voltage(long double val) { return float(val); }
+constexpr Voltage operator""_voltage(unsigned long long int val) { return float(val); }
 
-Resistance operator""_resistance(long double val);
-Resistance operator""_resistance(unsigned long long int val);
+constexpr Resistance operator""_resistance(long double val) { return float(val); }
+constexpr Resistance operator""_resistance(unsigned long long int val) { return float(val); }
 
-Watt operator""_watt(long double val);
-Watt operator""_watt(unsigned long long int val);
+constexpr Watt operator""_watt(long double val) { return float(val); }
+constexpr Watt operator""_watt(unsigned long long int val) { return float(val); }
 
-Volt operator""_volt(long double val);
-Volt operator""_volt(unsigned long long int val);
+constexpr Volt operator""_volt(long double val) { return float(val); }
+constexpr Volt operator""_volt(unsigned long long int val) { return float(val); }
 
-Ohm operator""_ohm(long double val);
-Ohm operator""_ohm(unsigned long long int val);
+constexpr Ohm operator""_ohm(long double val) { return float(val); }
+constexpr Ohm operator""_ohm(unsigned long long int val) { return float(val); }
 
-Weight operator""_weight(long double val);
-Weight operator""_weight(unsigned long long int val);
+constexpr Weight operator""_weight(long double val) { return float(val); }
+constexpr Weight operator""_weight(unsigned long long int val) { return float(val); }
 } // namespace literals
 
 /******************************* Additional functions ******************************/
 
-Degree rad_to_deg(const Radian & rad);
-Radian deg_to_rad(const Degree & deg);
+constexpr double DEGREES_PER_RADIAN = 57.2957795131;
 
-template <typename Dimensions>
-Unit<Dimensions> limitUnitBy(
-  const Unit<Dimensions> & value,
-  const Unit<Dimensions> & lower_bound,
-  const Unit<Dimensions> & upper_bound
+constexpr Degree rad_to_deg(const Radian & rad)
+{
+  return float(rad) * DEGREES_PER_RADIAN;
+}
+
+constexpr Radian deg_to_rad(const Degree & deg)
+{
+  return float(deg) / DEGREES_PER_RADIAN;
+}
+
+template <typename Dimensions, typename T>
+constexpr Unit<Dimensions, T> limitUnitBy(
+  const Unit<Dimensions, T> & value,
+  const Unit<Dimensions, T> & lower_bound,
+  const Unit<Dimensions, T> & upper_bound
 )
 {
 #ifdef max
@@ -478,6 +482,40 @@ Unit<Dimensions> limitUnitBy(
 #endif
 }
 
+/********************************* zero overhead ***********************************/
+
+static_assert(sizeof(Radian) == sizeof(float));
+static_assert(alignof(Radian) == alignof(float));
+static_assert(std::is_trivially_copyable_v<Radian>);
+static_assert(std::is_trivially_copyable_v<RotationalDamping>);
+static_assert(!std::is_polymorphic_v<Torque>);
+
+static_assert(Meter(3) / Second(2) == Velocity(1.5f));
+static_assert(std::is_same_v<decltype(Meter(1) * Kg(1) / (Second(1) * Second(1))), Newton>);
+static_assert(std::is_same_v<decltype(NewtonMeter(1) * Second(1) / Rad(1)), RotationalDamping>);
+static_assert(std::is_same_v<decltype(1 / Second(1)), Hertz>);
+static_assert(NewtonMeter(2) * Second(1) / Rad(4) == RotationalDamping(0.5f));
+static_assert(Radian(1) <= Radian(1) and Radian(1) <= Radian(2) and !(Radian(2) <= Radian(1)));
+static_assert(Radian(2) >= Radian(1) and Radian(1) < Radian(2) and Radian(1) != Radian(2));
+static_assert(limitUnitBy(Torque(30), Torque(-18), Torque(18)) == Torque(18));
+static_assert(literals::operator""_rad(2.0L) + literals::operator""_rad(1ULL) == Radian(3));
+static_assert(deg_to_rad(180) > Radian(3.14159f) and deg_to_rad(180) < Radian(3.1416f));
+
+static_assert(sizeof(WithScalar<Radian, double>) == sizeof(double));
+static_assert(sizeof(WithScalar<Radian, Fixed16<11>>) == sizeof(int16_t));
+static_assert(std::is_trivially_copyable_v<WithScalar<Torque, Fixed32<16>>>);
+static_assert(!std::is_convertible_v<Radian, WithScalar<Radian, double>>);
+static_assert(!std::is_convertible_v<float, WithScalar<Radian, Fixed32<16>>>);
+static_assert(std::is_constructible_v<WithScalar<Radian, double>, Radian>);
+static_assert(!std::is_constructible_v<WithScalar<Radian, double>, AngularVelocity>);
+static_assert(std::is_same_v<
+  decltype(WithScalar<NewtonMeter, double>(1) / WithScalar<Rad, double>(1)),
+  WithScalar<RotationalStiffness, double>
+>);
+static_assert(WithScalar<RotationalStiffness, Fixed32<16>>(Fixed32<16>(20)) * WithScalar<Rad, Fixed32<16>>(Fixed32<16>(0.25))
+              == WithScalar<Torque, Fixed32<16>>(5));
+static_assert(Radian(WithScalar<Radian, Fixed16<11>>(Radian(-1.5f))) == Radian(-1.5f));
+
 } // namespace kot_motor::dimensions
 
 #endif // DIMENSIONS_HPP
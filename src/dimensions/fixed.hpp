@@ -0,0 +1,175 @@
+#ifndef FIXED_HPP
+#define FIXED_HPP
+
+#include <stdint.h>
+#include <type_traits>
+
+namespace kot_motor::dimensions {
+
+// Binary fixed-point scalar, the Rep holds the value times 2^FractionBits.
+// The products and quotients go through the twice as wide integer and
+// wrap around on overflow as the Rep does. A float converts explicitly,
+// rounded to the nearest step, so a mixed expression doesn't compile.
+template <typename Rep, int FractionBits>
+class Fixed {
+  static_assert(std::is_integral_v<Rep> and std::is_signed_v<Rep>, "Fixed needs a signed integer");
+  static_assert(FractionBits > 0 and FractionBits < int(sizeof(Rep) * 8) - 1, "no integer bit left");
+
+public:
+  using rep = Rep;
+  using wide = std::conditional_t<sizeof(Rep) <= 2, int32_t, int64_t>;
+
+  static constexpr int FRACTION_BITS = FractionBits;
+  static constexpr wide ONE = wide(1) << FractionBits;
+
+private:
+  Rep raw;
+
+public:
+  constexpr Fixed()
+    : raw(0)
+  { }
+
+  constexpr Fixed(int value)
+    : raw(Rep(wide(value) * ONE))
+  { }
+
+  template <typename F, typename = std::enable_if_t<std::is_floating_point_v<F>>>
+  constexpr explicit Fixed(F value)
+    : raw(Rep(value * ONE + (value < 0 ? F(-0.5) : F(0.5))))
+  { }
+
+  // Another precision, the dropped bits are truncated
+  template <typename OtherRep, int OtherFractionBits>
+  constexpr explicit Fixed(const Fixed<OtherRep, OtherFractionBits> & other)
+    : raw(Rep(
+        OtherFractionBits > FractionBits
+          ? int64_t(other.rawValue()) / (int64_t(1) << (OtherFractionBits - FractionBits))
+          : int64_t(other.rawValue()) * (int64_t(1) << (FractionBits - OtherFractionBits))
+      ))
+  { }
+
+  static constexpr Fixed fromRaw(Rep raw)
+  {
+    Fixed fixed;
+    fixed.raw = raw;
+    return fixed;
+  }
+
+  constexpr Rep rawValue() const
+  {
+    return raw;
+  }
+
+  template <typename F, typename = std::enable_if_t<std::is_floating_point_v<F>>>
+  constexpr explicit operator F() const
+  {
+    return F(raw) / F(ONE);
+  }
+
+  constexpr explicit operator int() const
+  {
+    return int(raw / ONE);
+  }
+
+  constexpr Fixed operator+() const
+  {
+    return *this;
+  }
+
+  constexpr Fixed operator-() const
+  {
+    return fromRaw(Rep(-raw));
+  }
+
+  constexpr Fixed & operator+=(const Fixed & other)
+  {
+    raw = Rep(raw + other.raw);
+    return *this;
+  }
+
+  constexpr Fixed & operator-=(const Fixed & other)
+  {
+    raw = Rep(raw - other.raw);
+    return *this;
+  }
+
+  constexpr Fixed & operator*=(const Fixed & other)
+  {
+    raw = Rep(wide(raw) * other.raw / ONE);
+    return *this;
+  }
+
+  constexpr Fixed & operator/=(const Fixed & other)
+  {
+    raw = Rep(wide(raw) * ONE / other.raw);
+    return *this;
+  }
+
+  friend constexpr Fixed operator+(Fixed lhs, const Fixed & rhs)
+  {
+    return lhs += rhs;
+  }
+
+  friend constexpr Fixed operator-(Fixed lhs, const Fixed & rhs)
+  {
+    return lhs -= rhs;
+  }
+
+  friend constexpr Fixed operator*(Fixed lhs, const Fixed & rhs)
+  {
+    return lhs *= rhs;
+  }
+
+  friend constexpr Fixed operator/(Fixed lhs, const Fixed & rhs)
+  {
+    return lhs /= rhs;
+  }
+
+  friend constexpr bool operator==(const Fixed & lhs, const Fixed & rhs)
+  {
+    return lhs.raw == rhs.raw;
+  }
+
+  friend constexpr bool operator!=(const Fixed & lhs, const Fixed & rhs)
+  {
+    return lhs.raw != rhs.raw;
+  }
+
+  friend constexpr bool operator<(const Fixed & lhs, const Fixed & rhs)
+  {
+    return lhs.raw < rhs.raw;
+  }
+
+  friend constexpr bool operator>(const Fixed & lhs, const Fixed & rhs)
+  {
+    return lhs.raw > rhs.raw;
+  }
+
+  friend constexpr bool operator<=(const Fixed & lhs, const Fixed & rhs)
+  {
+    return lhs.raw <= rhs.raw;
+  }
+
+  friend constexpr bool operator>=(const Fixed & lhs, const Fixed & rhs)
+  {
+    return lhs.raw >= rhs.raw;
+  }
+};
+
+// The widths of the MIT protocol fields. The 12 bit velocities, torques
+// and gains fit the 16 bit representation with the fractional bits
+// their range leaves. The 16 bit position doesn't: ±12.5 rad leaves
+// Fixed16<11> a step of 4.9e-4 rad, coarser than the 3.8e-4 of the
+// wire, so a position taken from the feedback loses codes. Positions go
+// in Fixed32 or stay the wire codes (QuantizedUnit), the 32 bit
+// representation is for the sums as well.
+template <int FractionBits>
+using Fixed16 = Fixed<int16_t, FractionBits>;
+
+template <int FractionBits>
+using Fixed32 = Fixed<int32_t, FractionBits>;
+
+} // namespace kot_motor::dimensions
+
+#endif // FIXED_HPP
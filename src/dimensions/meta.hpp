@@ -2,9 +2,14 @@
 #define META_HPP
 
 #include <stddef.h>
+#include <utility>
 
 namespace kot_motor::dimensions::meta {
 
+// The lists are expanded as packs rather than walked element by
+// element, an operation on them is one instantiation whatever their
+// length.
+
 template <int a, int b>
 struct Plus {
   static int const value = a + b;
@@ -28,13 +33,11 @@ template <>
 struct IntList<> { };
 
 template <typename IL>
-struct CountLength {
-  static size_t const value = 1 + CountLength<typename IL::Tail>::value;
-};
+struct CountLength;
 
-template <>
-struct CountLength<IntList<>> {
-  const static size_t value = 0;
+template <int... Ns>
+struct CountLength<IntList<Ns...>> {
+  static size_t const value = sizeof...(Ns);
 };
 
 template <int N, typename IL>
@@ -45,15 +48,18 @@ struct IntCons<N, IntList<Ns...>> {
   using type = IntList<N, Ns...>;
 };
 
-template <size_t Size, typename IL = IntList<>>
-struct Generate {
-  using type =
-    typename Generate<Size - 1, typename IntCons<Size - 1, IL>::type>::type;
+template <typename Sequence, typename IL>
+struct Prepend;
+
+template <int... Ns, int... ILs>
+struct Prepend<std::integer_sequence<int, Ns...>, IntList<ILs...>> {
+  using type = IntList<Ns..., ILs...>;
 };
 
-template <typename IL>
-struct Generate<0, IL> {
-  using type = IL;
+// 0, 1, ... Size - 1 ahead of IL
+template <size_t Size, typename IL = IntList<>>
+struct Generate {
+  using type = typename Prepend<std::make_integer_sequence<int, int(Size)>, IL>::type;
 };
 
 template <typename IL1, typename IL2, template <int, int> class Func>
@@ -64,10 +70,24 @@ struct Transform<IntList<IL1s...>, IntList<IL2s...>, Func> {
   using type = IntList<Func<IL1s, IL2s>::value...>;
 };
 
-} // namespace kot_motor::dimensions::meta
+// The dimensions of a product and of a quotient, Transform with Plus
+// and Minus but with no Func to instantiate per element
+template <typename IL1, typename IL2>
+struct Sum;
 
-#endif // META_HPP
+template <int... IL1s, int... IL2s>
+struct Sum<IntList<IL1s...>, IntList<IL2s...>> {
+  using type = IntList<(IL1s + IL2s)...>;
+};
 
+template <typename IL1, typename IL2>
+struct Difference;
 
+template <int... IL1s, int... IL2s>
+struct Difference<IntList<IL1s...>, IntList<IL2s...>> {
+  using type = IntList<(IL1s - IL2s)...>;
+};
 
+} // namespace kot_motor::dimensions::meta
 
+#endif // META_HPP
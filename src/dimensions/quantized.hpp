@@ -0,0 +1,171 @@
+#ifndef QUANTIZED_HPP
+#define QUANTIZED_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include <type_traits>
+#include "dimensions.hpp"
+
+namespace kot_motor::dimensions {
+
+// A unit as the code of Bits bits it has on the wire: the steps above
+// the lower end of a range, which a Quantization holds. The arithmetic
+// is in steps and saturates at the ends of the range, two codes being
+// equal means the motor gets the same command.
+template <typename Dimensions, unsigned Bits>
+class QuantizedUnit {
+  static_assert(Bits > 0 and Bits <= 16, "the codes of the protocol have up to 16 bits");
+
+public:
+  using dimension = Dimensions;
+
+  static constexpr unsigned BITS = Bits;
+  static constexpr int32_t MAX_CODE = (int32_t(1) << Bits) - 1;
+
+private:
+  uint16_t val;
+
+public:
+  constexpr QuantizedUnit()
+    : val(0)
+  { }
+
+  // clamped into the Bits bits
+  constexpr explicit QuantizedUnit(int32_t code)
+    : val(uint16_t(std::min(std::max(code, int32_t(0)), MAX_CODE)))
+  { }
+
+  constexpr uint16_t code() const
+  {
+    return val;
+  }
+
+  constexpr QuantizedUnit & operator+=(int32_t steps)
+  {
+    *this = QuantizedUnit(int32_t(val) + steps);
+    return *this;
+  }
+
+  constexpr QuantizedUnit & operator-=(int32_t steps)
+  {
+    *this = QuantizedUnit(int32_t(val) - steps);
+    return *this;
+  }
+
+  friend constexpr QuantizedUnit operator+(QuantizedUnit unit, int32_t steps)
+  {
+    return unit += steps;
+  }
+
+  friend constexpr QuantizedUnit operator-(QuantizedUnit unit, int32_t steps)
+  {
+    return unit -= steps;
+  }
+
+  // the steps between two codes
+  friend constexpr int32_t operator-(const QuantizedUnit & lhs, const QuantizedUnit & rhs)
+  {
+    return int32_t(lhs.val) - int32_t(rhs.val);
+  }
+
+  friend constexpr bool operator==(const QuantizedUnit & lhs, const QuantizedUnit & rhs)
+  {
+    return lhs.val == rhs.val;
+  }
+
+  friend constexpr bool operator!=(const QuantizedUnit & lhs, const QuantizedUnit & rhs)
+  {
+    return lhs.val != rhs.val;
+  }
+
+  friend constexpr bool operator<(const QuantizedUnit & lhs, const QuantizedUnit & rhs)
+  {
+    return lhs.val < rhs.val;
+  }
+
+  friend constexpr bool operator>(const QuantizedUnit & lhs, const QuantizedUnit & rhs)
+  {
+    return lhs.val > rhs.val;
+  }
+
+  friend constexpr bool operator<=(const QuantizedUnit & lhs, const QuantizedUnit & rhs)
+  {
+    return lhs.val <= rhs.val;
+  }
+
+  friend constexpr bool operator>=(const QuantizedUnit & lhs, const QuantizedUnit & rhs)
+  {
+    return lhs.val >= rhs.val;
+  }
+};
+
+// The range the codes of a QuantizedUnit span, the MIT packing of one
+// field. The scales are computed once, quantizing is a clamp and a
+// multiply, truncated as the firmware expects, and the way back a
+// multiply-add.
+template <typename Dimensions, unsigned Bits>
+class Quantization {
+public:
+  using unit = Unit<Dimensions>;
+  using quantized = QuantizedUnit<Dimensions, Bits>;
+
+private:
+  float lower = 0.0f;
+  float upper = 0.0f;
+  float toCode = 0.0f;  // MAX_CODE / span
+  float toValue = 0.0f; // span / MAX_CODE
+
+public:
+  Quantization() = default;
+
+  constexpr Quantization(unit min, unit max)
+    : lower(min.value())
+    , upper(max.value())
+    , toCode(max > min ? float(quantized::MAX_CODE) / (max.value() - min.value()) : 0.0f)
+    , toValue((max.value() - min.value()) / float(quantized::MAX_CODE))
+  { }
+
+  constexpr unit min() const
+  {
+    return lower;
+  }
+
+  constexpr unit max() const
+  {
+    return upper;
+  }
+
+  // the value of one code step
+  constexpr unit step() const
+  {
+    return toValue;
+  }
+
+  constexpr quantized quantize(unit value) const
+  {
+    return quantized(int32_t((std::min(std::max(value.value(), lower), upper) - lower) * toCode));
+  }
+
+  constexpr unit value(quantized code) const
+  {
+    return float(code.code()) * toValue + lower;
+  }
+
+  // whether the value goes on the wire as it is
+  constexpr bool exact(unit value) const
+  {
+    return this->value(quantize(value)) == value;
+  }
+};
+
+// The codes take no more room than on the wire and convert back exactly
+static_assert(sizeof(QuantizedUnit<Radian::dimension, 16>) == sizeof(uint16_t));
+static_assert(std::is_trivially_copyable_v<QuantizedUnit<Radian::dimension, 16>>);
+static_assert(QuantizedUnit<Torque::dimension, 12>(5000).code() == 4095);
+static_assert(QuantizedUnit<Torque::dimension, 12>(-1).code() == 0);
+static_assert(Quantization<Torque::dimension, 12>(Torque(-2047.5f), Torque(2047.5f)).exact(Torque(0.5f)));
+static_assert(Quantization<Torque::dimension, 12>(Torque(-18.0f), Torque(18.0f)).quantize(Torque(18.0f)).code() == 4095);
+
+} // namespace kot_motor::dimensions
+
+#endif // QUANTIZED_HPP
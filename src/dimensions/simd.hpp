@@ -0,0 +1,219 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <stddef.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace kot_motor::dimensions::simd {
+
+// The lanes follow the flags of the translation unit, so everything
+// below lives in a namespace named after the instructions: translation
+// units built for different ones (the library with BUILD_NATIVE, its
+// users without) get definitions of their own instead of one picked by
+// the linker. The templates calling the kernels take Isa as a defaulted
+// parameter, which tags their instantiations the same way.
+#if defined(__AVX2__)
+inline namespace avx2 {
+#elif defined(__SSE2__)
+inline namespace sse2 {
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+inline namespace neon {
+#else
+inline namespace scalar {
+#endif
+
+struct Isa { };
+
+// The lanes of a scalar: one, for the scalars with no vector
+// instructions, double and Fixed among them
+template <typename T>
+struct Scalar {
+  static constexpr size_t WIDTH = 1;
+  using V = T;
+
+  static V load(const T * p) { return *p; }
+  static void store(T * p, V v) { *p = v; }
+  static V broadcast(T x) { return x; }
+  static V add(V a, V b) { return a + b; }
+  static V sub(V a, V b) { return a - b; }
+  static V mul(V a, V b) { return a * b; }
+  static V div(V a, V b) { return a / b; }
+  static V min(V a, V b) { return b < a ? b : a; }
+  static V max(V a, V b) { return a < b ? b : a; }
+};
+
+template <typename T>
+struct Lanes : Scalar<T> { };
+
+// The floats go by the vector width the build targets, the header is
+// compiled with the flags of its user
+#if defined(__AVX2__)
+
+template <>
+struct Lanes<float> {
+  static constexpr size_t WIDTH = 8;
+  using V = __m256;
+
+  static V load(const float * p) { return _mm256_loadu_ps(p); }
+  static void store(float * p, V v) { _mm256_storeu_ps(p, v); }
+  static V broadcast(float x) { return _mm256_set1_ps(x); }
+  static V add(V a, V b) { return _mm256_add_ps(a, b); }
+  static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+  static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+  static V div(V a, V b) { return _mm256_div_ps(a, b); }
+  static V min(V a, V b) { return _mm256_min_ps(b, a); }
+  static V max(V a, V b) { return _mm256_max_ps(b, a); }
+};
+
+#elif defined(__SSE2__)
+
+template <>
+struct Lanes<float> {
+  static constexpr size_t WIDTH = 4;
+  using V = __m128;
+
+  static V load(const float * p) { return _mm_loadu_ps(p); }
+  static void store(float * p, V v) { _mm_storeu_ps(p, v); }
+  static V broadcast(float x) { return _mm_set1_ps(x); }
+  static V add(V a, V b) { return _mm_add_ps(a, b); }
+  static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+  static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+  static V div(V a, V b) { return _mm_div_ps(a, b); }
+  static V min(V a, V b) { return _mm_min_ps(b, a); }
+  static V max(V a, V b) { return _mm_max_ps(b, a); }
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+template <>
+struct Lanes<float> {
+  static constexpr size_t WIDTH = 4;
+  using V = float32x4_t;
+
+  static V load(const float * p) { return vld1q_f32(p); }
+  static void store(float * p, V v) { vst1q_f32(p, v); }
+  static V broadcast(float x) { return vdupq_n_f32(x); }
+  static V add(V a, V b) { return vaddq_f32(a, b); }
+  static V sub(V a, V b) { return vsubq_f32(a, b); }
+  static V mul(V a, V b) { return vmulq_f32(a, b); }
+  static V div(V a, V b) { return vdivq_f32(a, b); }
+  static V min(V a, V b) { return vminq_f32(a, b); }
+  static V max(V a, V b) { return vmaxq_f32(a, b); }
+};
+
+#endif
+
+// The kernels take an operation generic over the lanes, called with
+// Lanes<T> over the whole vectors and with Scalar<T> over the rest:
+//   [](auto lanes, auto a, auto b) { return decltype(lanes)::add(a, b); }
+
+// out[i] = op(a[i], b[i])
+template <typename T, typename Op>
+inline void zip(const T * a, const T * b, T * out, size_t n, Op op)
+{
+  using L = Lanes<T>;
+  size_t whole = n - n % L::WIDTH;
+  size_t i = 0;
+  for (; i < whole; i += L::WIDTH) {
+    L::store(out + i, op(L{}, L::load(a + i), L::load(b + i)));
+  }
+  for (; i < n; i++) {
+    out[i] = op(Scalar<T>{}, a[i], b[i]);
+  }
+}
+
+// out[i] = op(a[i], k)
+template <typename T, typename Op>
+inline void map(const T * a, T k, T * out, size_t n, Op op)
+{
+  using L = Lanes<T>;
+  typename L::V kv = L::broadcast(k);
+  size_t whole = n - n % L::WIDTH;
+  size_t i = 0;
+  for (; i < whole; i += L::WIDTH) {
+    L::store(out + i, op(L{}, L::load(a + i), kv));
+  }
+  for (; i < n; i++) {
+    out[i] = op(Scalar<T>{}, a[i], k);
+  }
+}
+
+// op(...op(op(a[0], a[1]), a[2])...), in the order of the lanes rather
+// than of the elements, a float sum rounds differently than a loop's
+template <typename T, typename Op>
+inline T reduce(const T * a, size_t n, Op op)
+{
+  using L = Lanes<T>;
+  size_t i = 0;
+  T result = a[0];
+  if (n >= 2 * L::WIDTH) {
+    typename L::V acc = L::load(a);
+    size_t whole = n - n % L::WIDTH;
+    for (i = L::WIDTH; i < whole; i += L::WIDTH) {
+      acc = op(L{}, acc, L::load(a + i));
+    }
+    T lanes[L::WIDTH];
+    L::store(lanes, acc);
+    result = lanes[0];
+    for (size_t k = 1; k < L::WIDTH; k++) {
+      result = op(Scalar<T>{}, result, lanes[k]);
+    }
+  } else {
+    i = 1;
+  }
+  for (; i < n; i++) {
+    result = op(Scalar<T>{}, result, a[i]);
+  }
+  return result;
+}
+
+// the sum of a[i] * b[i]
+template <typename T>
+inline T dot(const T * a, const T * b, size_t n)
+{
+  using L = Lanes<T>;
+  typename L::V acc = L::broadcast(T(0));
+  size_t whole = n - n % L::WIDTH;
+  size_t i = 0;
+  for (; i < whole; i += L::WIDTH) {
+    acc = L::add(acc, L::mul(L::load(a + i), L::load(b + i)));
+  }
+  T lanes[L::WIDTH];
+  L::store(lanes, acc);
+  T result = lanes[0];
+  for (size_t k = 1; k < L::WIDTH; k++) {
+    result = result + lanes[k];
+  }
+  for (; i < n; i++) {
+    result = result + a[i] * b[i];
+  }
+  return result;
+}
+
+// out[i] = min(max(a[i], lower[i]), upper[i])
+template <typename T>
+inline void clamp(const T * a, const T * lower, const T * upper, T * out, size_t n)
+{
+  using L = Lanes<T>;
+  size_t whole = n - n % L::WIDTH;
+  size_t i = 0;
+  for (; i < whole; i += L::WIDTH) {
+    L::store(out + i, L::min(L::max(L::load(a + i), L::load(lower + i)), L::load(upper + i)));
+  }
+  for (; i < n; i++) {
+    out[i] = Scalar<T>::min(Scalar<T>::max(a[i], lower[i]), upper[i]);
+  }
+}
+
+} // inline namespace
+
+} // namespace kot_motor::dimensions::simd
+
+#endif // SIMD_HPP
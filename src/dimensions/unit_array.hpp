@@ -0,0 +1,323 @@
+#ifndef UNIT_ARRAY_HPP
+#define UNIT_ARRAY_HPP
+
+#include <stddef.h>
+#include <type_traits>
+#include "dimensions.hpp"
+#include "simd.hpp"
+
+namespace kot_motor::dimensions {
+
+// N units of one dimension, contiguous and aligned for the widest
+// vectors, as one value per joint of a robot. The element-wise
+// arithmetic, the clamping and the reductions run over the scalars
+// with the vector instructions the build targets (AVX2, SSE2 or NEON
+// for floats) and check the dimensions as Unit does. The elements are
+// the units themselves, an element is read and written as a unit.
+template <typename SetDimensions, size_t N, typename T = float>
+class UnitArray {
+  static_assert(N > 0, "an empty UnitArray");
+
+public:
+  using unit = Unit<SetDimensions, T>;
+  using dimension = SetDimensions;
+  using scalar = T;
+
+  static constexpr size_t SIZE = N;
+
+private:
+  alignas(32) unit values[N];
+
+public:
+  constexpr UnitArray()
+    : values()
+  { }
+
+  // the same unit in every element
+  constexpr explicit UnitArray(unit value)
+    : values()
+  {
+    for (auto && element : values) {
+      element = value;
+    }
+  }
+
+  // the first units, the rest zero, a list longer than the array doesn't
+  // compile. A single unit fills the array as above.
+  template <
+    typename... Units,
+    typename = std::enable_if_t<(sizeof...(Units) > 1 and (std::is_convertible_v<Units, unit> and ...))>>
+  constexpr UnitArray(Units... units)
+    : values{unit(units)...}
+  {
+    static_assert(sizeof...(Units) <= N, "more units than the UnitArray holds");
+  }
+
+  constexpr size_t size() const
+  {
+    return N;
+  }
+
+  constexpr unit & operator[](size_t i)
+  {
+    return values[i];
+  }
+
+  constexpr const unit & operator[](size_t i) const
+  {
+    return values[i];
+  }
+
+  constexpr unit * begin()
+  {
+    return values;
+  }
+
+  constexpr unit * end()
+  {
+    return values + N;
+  }
+
+  constexpr const unit * begin() const
+  {
+    return values;
+  }
+
+  constexpr const unit * end() const
+  {
+    return values + N;
+  }
+
+  // The scalars, a unit is laid out as its scalar
+  T * data()
+  {
+    return reinterpret_cast<T *>(values);
+  }
+
+  const T * data() const
+  {
+    return reinterpret_cast<const T *>(values);
+  }
+
+  template <typename Isa = simd::Isa>
+  UnitArray & operator+=(const UnitArray & other)
+  {
+    simd::zip(data(), other.data(), data(), N, [](auto lanes, auto a, auto b) {
+      return decltype(lanes)::add(a, b);
+    });
+    return *this;
+  }
+
+  template <typename Isa = simd::Isa>
+  UnitArray & operator-=(const UnitArray & other)
+  {
+    simd::zip(data(), other.data(), data(), N, [](auto lanes, auto a, auto b) {
+      return decltype(lanes)::sub(a, b);
+    });
+    return *this;
+  }
+
+  template <typename Isa = simd::Isa>
+  UnitArray & operator*=(T k)
+  {
+    simd::map(data(), k, data(), N, [](auto lanes, auto a, auto b) {
+      return decltype(lanes)::mul(a, b);
+    });
+    return *this;
+  }
+
+  template <typename Isa = simd::Isa>
+  UnitArray & operator/=(T k)
+  {
+    simd::map(data(), k, data(), N, [](auto lanes, auto a, auto b) {
+      return decltype(lanes)::div(a, b);
+    });
+    return *this;
+  }
+
+  template <typename Isa = simd::Isa>
+  UnitArray operator-() const
+  {
+    UnitArray result;
+    simd::map(data(), T(-1), result.data(), N, [](auto lanes, auto a, auto b) {
+      return decltype(lanes)::mul(a, b);
+    });
+    return result;
+  }
+};
+
+static_assert(std::is_standard_layout_v<Radian> and sizeof(Radian) == sizeof(float));
+
+/************************** '+' and '-' between UnitArray *************************/
+
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<Dimensions, N, T> operator+(const UnitArray<Dimensions, N, T> & lhs, const UnitArray<Dimensions, N, T> & rhs)
+{
+  UnitArray<Dimensions, N, T> result = lhs;
+  return result += rhs;
+}
+
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<Dimensions, N, T> operator-(const UnitArray<Dimensions, N, T> & lhs, const UnitArray<Dimensions, N, T> & rhs)
+{
+  UnitArray<Dimensions, N, T> result = lhs;
+  return result -= rhs;
+}
+
+/************************** '*' and '/' between UnitArray *************************/
+// element by element
+
+template <typename Dimensions1, typename Dimensions2, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<typename Sum<Dimensions1, Dimensions2>::type, N, T>
+  operator*(const UnitArray<Dimensions1, N, T> & lhs, const UnitArray<Dimensions2, N, T> & rhs)
+{
+  UnitArray<typename Sum<Dimensions1, Dimensions2>::type, N, T> result;
+  simd::zip(lhs.data(), rhs.data(), result.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::mul(a, b);
+  });
+  return result;
+}
+
+template <typename Dimensions1, typename Dimensions2, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<typename Difference<Dimensions1, Dimensions2>::type, N, T>
+  operator/(const UnitArray<Dimensions1, N, T> & lhs, const UnitArray<Dimensions2, N, T> & rhs)
+{
+  UnitArray<typename Difference<Dimensions1, Dimensions2>::type, N, T> result;
+  simd::zip(lhs.data(), rhs.data(), result.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::div(a, b);
+  });
+  return result;
+}
+
+/******************** '*' and '/' between UnitArray and a Unit ********************/
+// the unit applies to every element, as a gain to all joints
+
+template <typename Dimensions1, typename Dimensions2, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<typename Sum<Dimensions1, Dimensions2>::type, N, T>
+  operator*(const UnitArray<Dimensions1, N, T> & array, const Unit<Dimensions2, T> & unit)
+{
+  UnitArray<typename Sum<Dimensions1, Dimensions2>::type, N, T> result;
+  simd::map(array.data(), unit.value(), result.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::mul(a, b);
+  });
+  return result;
+}
+
+template <typename Dimensions1, typename Dimensions2, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<typename Sum<Dimensions1, Dimensions2>::type, N, T>
+  operator*(const Unit<Dimensions2, T> & unit, const UnitArray<Dimensions1, N, T> & array)
+{
+  return array * unit;
+}
+
+template <typename Dimensions1, typename Dimensions2, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<typename Difference<Dimensions1, Dimensions2>::type, N, T>
+  operator/(const UnitArray<Dimensions1, N, T> & array, const Unit<Dimensions2, T> & unit)
+{
+  UnitArray<typename Difference<Dimensions1, Dimensions2>::type, N, T> result;
+  simd::map(array.data(), unit.value(), result.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::div(a, b);
+  });
+  return result;
+}
+
+/******************* '*' and '/' between UnitArray and numbers ********************/
+
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<Dimensions, N, T>
+  operator*(const UnitArray<Dimensions, N, T> & array, typename UnitArray<Dimensions, N, T>::scalar k)
+{
+  UnitArray<Dimensions, N, T> result = array;
+  return result *= k;
+}
+
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<Dimensions, N, T>
+  operator*(typename UnitArray<Dimensions, N, T>::scalar k, const UnitArray<Dimensions, N, T> & array)
+{
+  return array * k;
+}
+
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<Dimensions, N, T>
+  operator/(const UnitArray<Dimensions, N, T> & array, typename UnitArray<Dimensions, N, T>::scalar k)
+{
+  UnitArray<Dimensions, N, T> result = array;
+  return result /= k;
+}
+
+/********************************** Reductions ************************************/
+// The vector reductions add in the order of the lanes, the float sums
+// may differ in the last bits from a loop over the elements
+
+template <typename Dimensions1, typename Dimensions2, size_t N, typename T, typename Isa = simd::Isa>
+Unit<typename Sum<Dimensions1, Dimensions2>::type, T>
+  dot(const UnitArray<Dimensions1, N, T> & lhs, const UnitArray<Dimensions2, N, T> & rhs)
+{
+  return simd::dot(lhs.data(), rhs.data(), N);
+}
+
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+Unit<Dimensions, T> sum(const UnitArray<Dimensions, N, T> & array)
+{
+  return simd::reduce(array.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::add(a, b);
+  });
+}
+
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+Unit<Dimensions, T> minimum(const UnitArray<Dimensions, N, T> & array)
+{
+  return simd::reduce(array.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::min(a, b);
+  });
+}
+
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+Unit<Dimensions, T> maximum(const UnitArray<Dimensions, N, T> & array)
+{
+  return simd::reduce(array.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::max(a, b);
+  });
+}
+
+/******************************** Clamping ***************************************/
+
+// each element within its own bounds, the limits of each joint
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<Dimensions, N, T> limitUnitBy(
+  const UnitArray<Dimensions, N, T> & value,
+  const UnitArray<Dimensions, N, T> & lower_bound,
+  const UnitArray<Dimensions, N, T> & upper_bound
+)
+{
+  UnitArray<Dimensions, N, T> result;
+  simd::clamp(value.data(), lower_bound.data(), upper_bound.data(), result.data(), N);
+  return result;
+}
+
+// every element within the same bounds
+template <typename Dimensions, size_t N, typename T, typename Isa = simd::Isa>
+UnitArray<Dimensions, N, T> limitUnitBy(
+  const UnitArray<Dimensions, N, T> & value,
+  const Unit<Dimensions, T> & lower_bound,
+  const Unit<Dimensions, T> & upper_bound
+)
+{
+  UnitArray<Dimensions, N, T> result;
+  simd::map(value.data(), lower_bound.value(), result.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::max(a, b);
+  });
+  simd::map(result.data(), upper_bound.value(), result.data(), N, [](auto lanes, auto a, auto b) {
+    return decltype(lanes)::min(a, b);
+  });
+  return result;
+}
+
+static_assert(sizeof(UnitArray<Radian::dimension, 16>) == 16 * sizeof(float));
+static_assert(alignof(UnitArray<Radian::dimension, 12>) == 32);
+static_assert(std::is_trivially_copyable_v<UnitArray<Torque::dimension, 12>>);
+
+} // namespace kot_motor::dimensions
+
+#endif // UNIT_ARRAY_HPP
@@ -2,6 +2,7 @@
 #define CONFIG_HPP
 
 #include "motor.hpp"
+#include "motor_codec.hpp"
 #include "dimensions/dimensions.hpp"
 
 namespace kot_motor::config {
@@ -16,11 +17,39 @@ using dimensions::RotationalDamping;
 using dimensions::RotationalStiffness;
 using dimensions::Torque;
 
+namespace model {
+
+// The limits of the motor models as constants, for StaticCodec
+struct DefaultMotor {
+  static constexpr MotorCodec::Ranges ranges{
+    {-12.5f, 12.5f}, {-50.0f, 50.0f}, {-16.0f, 16.0f}, {0.0f, 500.0f}, {0.0f, 5.0f}
+  };
+};
+
+struct CubemarsAk7010 {
+  static constexpr MotorCodec::Ranges ranges{
+    {-12.5f, 12.5f}, {-50.0f, 50.0f}, {-24.5f, 24.5f}, {0.0f, 500.0f}, {0.0f, 5.0f}
+  };
+};
+
+} // namespace model
+
+inline Motor::MotorLimits limitsOf(const MotorCodec::Ranges & ranges)
+{
+  return Motor::MotorLimits{
+    Limits<Radian>{ranges.position.min, ranges.position.max},
+    Limits<AngularVelocity>{ranges.velocity.min, ranges.velocity.max},
+    Limits<Torque>{ranges.torque.min, ranges.torque.max},
+    Limits<RotationalStiffness>{ranges.stiffness.min, ranges.stiffness.max},
+    Limits<RotationalDamping>{ranges.damper.min, ranges.damper.max}
+  };
+}
+
 inline Motor::MotorInfo default_motor{
 
   Motor::MotorSpecification{"default", "default", 500, 24, 0.12f, 5, 16, 50},
 
-  Motor::MotorLimits{Limits<Radian>{-12.5f, 12.5f}, Limits<AngularVelocity>{-50, 50}, Limits<Torque>{-16, 16}, Limits<RotationalStiffness>{0, 500}, Limits<RotationalDamping>{0.0f, 5.0f}}
+  limitsOf(model::DefaultMotor::ranges)
 };
 
 inline Motor::MotorInfo cubemars_ak7010{
@@ -29,7 +58,7 @@ inline Motor::MotorInfo cubemars_ak7010{
                             "Cubemars", "AK70-10", 500, 24, 0.12f, 8.8f, 24.5f, 50
   },
 
-  Motor::MotorLimits{Limits<Radian>{-12.5f, 12.5f}, Limits<AngularVelocity>{-50, 50}, Limits<Torque>{-24.5f, 24.5f}, Limits<RotationalStiffness>{0, 500}, Limits<RotationalDamping>{0.0f, 5.0f}}
+  limitsOf(model::CubemarsAk7010::ranges)
 };
 
 } // namespace kot_motor::config
@@ -1,3 +1,4 @@
+#include <utility>
 #include "motor.hpp"
 #include "basic_transport.hpp"
 
@@ -5,6 +6,17 @@ using namespace kot_motor::motor;
 using kot_motor::motor::Motor;
 using kot_motor::transport::BasicTransport;
 
+MotorCodec::Ranges kot_motor::motor::codecRanges(const Motor::MotorLimits & limits)
+{
+  auto range = [](auto && limit) {
+    return MotorCodec::Range{float(limit.min), float(limit.max)};
+  };
+  return MotorCodec::Ranges{
+    range(limits.position), range(limits.velocity), range(limits.torque),
+    range(limits.stiffness), range(limits.damper)
+  };
+}
+
 Motor::Motor(
   BasicTransport & bus, uint8_t canId, uint8_t masterCanId, const MotorInfo & config
 ) noexcept
@@ -12,12 +24,40 @@ Motor::Motor(
   , canId(canId)
   , masterCanId(masterCanId)
   , config(config)
+  , codec(codecRanges(config.motorHwLimits))
   , inputParams()
+  , inputCodes(codec.quantize(MotorCodec::Command{}))
+  , sentCodes(inputCodes)
   , outputParams()
-{ }
+{
+  bus.attachMotor(canId, masterCanId);
+}
 
-Motor::Motor(Motor && other) = default;
-Motor::~Motor() = default;
+Motor::Motor(Motor && other)
+  : bus(other.bus)
+  , canId(other.canId)
+  , masterCanId(other.masterCanId)
+  , config(std::move(other.config))
+  , codec(other.codec)
+  , inputParams(other.inputParams)
+  , inputCodes(other.inputCodes)
+  , sentCodes(other.sentCodes)
+  , outputParams(other.outputParams)
+  , motorState(other.motorState)
+  , health(other.health)
+  , thresholds(other.thresholds)
+  , linkCallback(other.linkCallback)
+  , linkContext(other.linkContext)
+  , awaitingReply(other.awaitingReply)
+{
+  // the moved-from motor detaches itself when it is destroyed
+  bus.attachMotor(canId, masterCanId);
+}
+
+Motor::~Motor()
+{
+  bus.detachMotor(canId, masterCanId);
+}
 
 /***************************** State Control *******************************/
 
@@ -25,7 +65,7 @@ BasicTransport::Status Motor::enterMotorMode()
 {
   CanFrameBuff buff = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFC};
   BasicTransport::CanFrame canFrame(
-    canId, masterCanId, buff.data(), buff.size()
+    canId, buff.data(), buff.size()
   );
 
   BasicTransport::Status status = sendCmd(canFrame);
@@ -41,10 +81,11 @@ BasicTransport::Status Motor::exitMotorMode()
 {
   CanFrameBuff buff = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFD};
   BasicTransport::CanFrame canFrame(
-    canId, masterCanId, buff.data(), buff.size()
+    canId, buff.data(), buff.size()
   );
 
-  BasicTransport::Status status = sendCmd(canFrame);
+  // must not wait behind the queued setpoints
+  BasicTransport::Status status = sendUrgentCmd(canFrame);
 
   if (status == BasicTransport::Status::SUCCESS) {
     motorState = MotorState::MOTOR_MODE_NOT_ACTIVE;
@@ -57,7 +98,7 @@ BasicTransport::Status Motor::setProgramZero()
 {
   CanFrameBuff buff = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE};
   BasicTransport::CanFrame canFrame(
-    canId, masterCanId, buff.data(), buff.size()
+    canId, buff.data(), buff.size()
   );
 
   BasicTransport::Status status = sendCmd(canFrame);
@@ -72,10 +113,12 @@ BasicTransport::Status Motor::resetParameters()
   inputParams.torque = 0.0f;
   inputParams.stiffness = 0.0f;
   inputParams.damper = 0.0f;
+  inputCodes = codec.quantize(MotorCodec::Command{});
 
   outputParams.position = 0.0f;
   outputParams.velocity = 0.0f;
   outputParams.torque = 0.0f;
+  outputParams.timestamp = {};
 
   BasicTransport::Status status = sendToMotor();
 
@@ -86,49 +129,124 @@ BasicTransport::Status Motor::resetParameters()
 
 BasicTransport::Status Motor::sendToMotor()
 {
-  auto cmd = packCmd(inputParams);
-  auto status = sendCmd(cmd);
+  BasicTransport::CanFrame cmd = command();
+  auto status = isReleasing() ? sendUrgentCmd(cmd) : sendCmd(cmd);
+  if (status == BasicTransport::Status::SUCCESS) {
+    sentCodes = inputCodes;
+  }
   return status;
 }
 
 BasicTransport::Status Motor::getActualParameters()
 {
   auto replay = getReply();
-  if (replay.has_value()) {
-    outputParams = unpackReplay(replay.value());
-    return BasicTransport::Status::SUCCESS;
-  } else {
+  if (!replay.has_value()) {
     return BasicTransport::Status::FAIL;
   }
+  return applyReply(replay.value());
+}
+
+BasicTransport::CanFrame Motor::command()
+{
+  BasicTransport::CanFrame cmd;
+  packCmd(inputCodes, cmd);
+  return cmd;
+}
+
+bool Motor::isReleasing() const
+{
+  // a limp motor is the safe state, so going limp goes ahead of the
+  // queue, the commands of a motor limp already don't
+  return isLimp(inputCodes) and !isLimp(sentCodes);
+}
+
+bool Motor::isLimp(const MotorCodec::Codes & codes) const
+{
+  MotorCodec::Codes limp = codec.quantize(MotorCodec::Command{});
+  return codes.torque == limp.torque and codes.stiffness == limp.stiffness and codes.damper == limp.damper;
+}
+
+BasicTransport::Status Motor::applyReply(const BasicTransport::CanFrame & canFrame)
+{
+  if (canFrame.size < 6) {
+    return BasicTransport::Status::FAIL;
+  }
+  outputParams = unpackReplay(canFrame);
+  trackReply(canFrame);
+  return BasicTransport::Status::SUCCESS;
+}
+
+void Motor::commandSent()
+{
+  frameSent();
+  sentCodes = inputCodes;
+}
+
+bool Motor::commandChanged() const
+{
+  return inputCodes != sentCodes;
+}
+
+void Motor::frameSent()
+{
+  if (awaitingReply) {
+    health.misses++;
+    health.consecutiveMisses++;
+    updateLinkState();
+  }
+  awaitingReply = true;
+}
+
+/******************************* Link health *******************************/
+
+void Motor::linkThresholds(const LinkThresholds & thresholds)
+{
+  this->thresholds = thresholds;
+}
+
+void Motor::onLinkChange(LinkCallback callback, void * context)
+{
+  linkCallback = callback;
+  linkContext = context;
+}
+
+const Motor::LinkHealth & Motor::linkHealth() const
+{
+  return health;
+}
+
+std::chrono::nanoseconds Motor::timeSinceReply(BasicTransport::CanFrame::Clock::time_point now) const
+{
+  return now - health.lastReply;
 }
 
 /************************ InputParameters setters **************************/
 
 void Motor::position(Radian pos)
 {
-  setParameterHelper(pos, inputParams.position, config.motorHwLimits.position);
+  setParameterHelper(pos, inputParams.position, inputCodes.position, codec.position());
 }
 
 void Motor::velocity(AngularVelocity vel)
 {
-  setParameterHelper(vel, inputParams.velocity, config.motorHwLimits.velocity);
+  setParameterHelper(vel, inputParams.velocity, inputCodes.velocity, codec.velocity());
 }
 
 void Motor::torque(Torque torq)
 {
-  setParameterHelper(torq, inputParams.torque, config.motorHwLimits.torque);
+  setParameterHelper(torq, inputParams.torque, inputCodes.torque, codec.torque());
 }
 
 void Motor::stiffness(RotationalStiffness stiff)
 {
   setParameterHelper(
-    stiff, inputParams.stiffness, config.motorHwLimits.stiffness
+    stiff, inputParams.stiffness, inputCodes.stiffness, codec.stiffness()
   );
 }
 
 void Motor::damper(RotationalDamping damp)
 {
-  setParameterHelper(damp, inputParams.damper, config.motorHwLimits.damper);
+  setParameterHelper(damp, inputParams.damper, inputCodes.damper, codec.damper());
 }
 
 /*********************** Motor information getters *************************/
@@ -153,6 +271,11 @@ const Motor::MotorInfo & Motor::motorInfo() const
   return config;
 }
 
+const MotorCodec & Motor::motorCodec() const
+{
+  return codec;
+}
+
 /****************************** State getters *****************************/
 
 Motor::MotorState Motor::state() const
@@ -216,205 +339,93 @@ Torque Motor::actualTorque() const
 
 /***************** Packing/unpacking, sending/receivring ******************/
 
-BasicTransport::CanFrame Motor::packCmd(const InputParameters & inParams)
-{
-  /*
-   * CAN Command Packet Structure
-   *
-   * 16 bit position command, between -4*pi and 4*pi
-   * 12 bit velocity command, between -30 and + 30 rad/s
-   * 12 bit kp, between 0 and 500 N-m/rad
-   * 12 bit kd, between 0 and 100 N-m*s/rad
-   * 12 bit feed forward torque, between -18 and 18 N-m
-   * CAN Packet is 8 8-bit words
-   * Formatted as follows.  For each quantity, bit 0 is LSB
-   * 0: [position[15-8]]
-   * 1: [position[7-0]]
-   * 2: [velocity[11-4]]
-   * 3: [velocity[3-0], kp[11-8]]
-   * 4: [kp[7-0]]
-   * 5: [kd[11-4]]
-   * 6: [kd[3-0], torque[11-8]]
-   * 7: [torque[7-0]]
-   */
-
-  // constrain parameters ///
-  Radian p_des = dimensions::limitUnitBy(
-    inputParams.position,
-    config.motorHwLimits.position.min,
-    config.motorHwLimits.position.max
-  );
-  AngularVelocity v_des = dimensions::limitUnitBy(
-    inputParams.velocity,
-    config.motorHwLimits.velocity.min,
-    config.motorHwLimits.velocity.max
-  );
-  Torque t_ff = dimensions::limitUnitBy(
-    inputParams.torque,
-    config.motorHwLimits.torque.min,
-    config.motorHwLimits.torque.max
-  );
-  RotationalStiffness kp = dimensions::limitUnitBy(
-    inputParams.stiffness,
-    config.motorHwLimits.stiffness.min,
-    config.motorHwLimits.stiffness.max
-  );
-  RotationalDamping kd = dimensions::limitUnitBy(
-    inputParams.damper,
-    config.motorHwLimits.damper.min,
-    config.motorHwLimits.damper.max
-  );
-
-  /// convert floats to uint32_ts ///
-  uint32_t p_int = floatToUint(
-    static_cast<float>(p_des),
-    static_cast<float>(config.motorHwLimits.position.min),
-    static_cast<float>(config.motorHwLimits.position.max),
-    16
-  );
-  uint32_t v_int = floatToUint(
-    static_cast<float>(v_des),
-    static_cast<float>(config.motorHwLimits.velocity.min),
-    static_cast<float>(config.motorHwLimits.velocity.max),
-    12
-  );
-  uint32_t t_int = floatToUint(
-    static_cast<float>(t_ff),
-    static_cast<float>(config.motorHwLimits.torque.min),
-    static_cast<float>(config.motorHwLimits.torque.max),
-    12
-  );
-  uint32_t kp_int = floatToUint(
-    static_cast<float>(kp),
-    static_cast<float>(config.motorHwLimits.stiffness.min),
-    static_cast<float>(config.motorHwLimits.stiffness.max),
-    12
-  );
-  uint32_t kd_int = floatToUint(
-    static_cast<float>(kd),
-    static_cast<float>(config.motorHwLimits.damper.min),
-    static_cast<float>(config.motorHwLimits.damper.max),
-    12
-  );
-
-  // TODO get an feedback here ?
-
-  CanFrameBuff buff;
-  buff[0] = p_int >> 8;
-  buff[1] = p_int & 0xFF;
-  buff[2] = v_int >> 4;
-  buff[3] = ((v_int & 0xF) << 4) | (kp_int >> 8);
-  buff[4] = kp_int & 0xFF;
-  buff[5] = kd_int >> 4;
-  buff[6] = ((kd_int & 0xF) << 4) | (t_int >> 8);
-  buff[7] = t_int & 0xFF;
-
-  return BasicTransport::CanFrame{canId, masterCanId, buff.data(), buff.size()};
+void Motor::packCmd(const MotorCodec::Codes & codes, BasicTransport::CanFrame & canFrame)
+{
+  // the setters quantized the parameters already,
+  // packed right into the frame handed to the transport
+  canFrame.canId = canId;
+  canFrame.size = 8;
+  MotorCodec::pack(codes, canFrame.data);
 }
 
 BasicTransport::Status Motor::sendCmd(const BasicTransport::CanFrame & canFrame)
 {
   BasicTransport::Status status = bus.write(canFrame);
+  if (status == BasicTransport::Status::SUCCESS) {
+    frameSent();
+  }
   return status;
 }
 
-std::optional<BasicTransport::CanFrame> Motor::getReply()
+BasicTransport::Status Motor::sendUrgentCmd(const BasicTransport::CanFrame & canFrame)
 {
-  // if (bus.available())
-  // return {};
-
-  // TODO how readMsgBuf() function works ????
-
-  // reading all up to the most actual data
-  // uint8_t len = 0;
-  // unsigned long sender_id = 0; // why this does work?
-  // uint64_t sender_id = 0; // and this does not ?????
-  BasicTransport::CanFrame canFrame;
-  // while (bus.available()) {
-  //  bus.read(&sender_id, &len, buff.data());
-  //}
-  return canFrame;
+  BasicTransport::Status status = bus.writeUrgent(canFrame);
+  if (status == BasicTransport::Status::SUCCESS) {
+    frameSent();
+  }
+  return status;
 }
 
-Motor::OutputParameters Motor::unpackReplay(const BasicTransport::CanFrame & canFrame)
+std::optional<BasicTransport::CanFrame> Motor::getReply()
 {
-  /*
-   * CAN Reply Packet Structure:
-   *
-   * 16 bit position, between -4*pi and 4*pi
-   * 12 bit velocity, between -30 and + 30 rad/s
-   * 12 bit current, between -40 and 40;
-   * CAN Packet is 5 8-bit words
-   * Formatted as follows.  For each quantity, bit 0 is LSB
-   * 0: [position[15-8]]
-   * 1: [position[7-0]]
-   * 2: [velocity[11-4]]
-   * 3: [velocity[3-0], current[11-8]]
-   * 4: [current[7-0]]
-   * float p_des = constrain(this->position, this->positionLimits[0],
-   * this->positionLimits[1]);
-   */
-
-  // uint32_t id = buff[0]; // TODO what's this?
-  uint32_t p_int = (canFrame.data[1] << 8) | canFrame.data[2];
-  uint32_t v_int = (canFrame.data[3] << 4) | (canFrame.data[4] >> 4);
-  uint32_t i_int = ((canFrame.data[4] & 0xF) << 8) | canFrame.data[5];
-
-  OutputParameters feedback;
-
-  feedback.position = uintToFloat(
-    p_int,
-    static_cast<float>(config.motorHwLimits.position.min),
-    static_cast<float>(config.motorHwLimits.position.max),
-    16
-  );
-  feedback.velocity = uintToFloat(
-    v_int,
-    static_cast<float>(config.motorHwLimits.velocity.min),
-    static_cast<float>(config.motorHwLimits.velocity.max),
-    12
-  );
-  feedback.torque = uintToFloat(
-    i_int,
-    static_cast<float>(config.motorHwLimits.torque.min),
-    -static_cast<float>(config.motorHwLimits.torque.max),
-    12
-  );
-
-  return feedback;
+  // reading all up to the most actual data, the replies of the other
+  // motors on the bus are kept for them in the transport
+  bus.receive();
+  return bus.takeReply(canId);
 }
 
-constexpr uint32_t Motor::floatToUint(float x, float x_min, float x_max, uint8_t bits)
+void Motor::trackReply(const BasicTransport::CanFrame & canFrame)
 {
-  /* Converts a float to an unsigned int, given range and number of bits */
-  float span = x_max - x_min;
-  float offset = x_min;
-  unsigned int pgg = 0;
-
-  if (bits == 12) {
-    pgg = (unsigned int)((x - offset) * 4095.0 / span);
-  } else if (bits == 16) {
-    pgg = (unsigned int)((x - offset) * 65535.0 / span);
+  bool stamped = canFrame.timestamp != BasicTransport::CanFrame::Clock::time_point();
+  if (stamped) {
+    health.lastReply = canFrame.timestamp;
   }
-
-  return pgg;
+  // a late reply to an older command doesn't tell about the latest one
+  if (!awaitingReply or !bus.answersLatestCommand(canId, canFrame)) {
+    return;
+  }
+  awaitingReply = false;
+  health.consecutiveMisses = 0;
+
+  if (stamped) {
+    auto sample = canFrame.timestamp - bus.lastCommandTime(canId);
+    if (health.latency.count() == 0) {
+      health.latency = sample;
+    } else {
+      health.latency += std::chrono::nanoseconds(
+        int64_t(thresholds.latencyWeight * (sample - health.latency).count())
+      );
+    }
+  }
+  updateLinkState();
 }
 
-constexpr float Motor::uintToFloat(uint32_t x_int, float x_min, float x_max, uint8_t bits)
+void Motor::updateLinkState()
 {
-  /* converts uint32_t to float, given range and number of bits */
-  float span = x_max - x_min;
-  float offset = x_min;
-  float pgg = 0;
-
-  if (bits == 12) {
-    pgg = ((float)x_int) * span / 4095.0 + offset;
-  } else if (bits == 16) {
-    pgg = ((float)x_int) * span / 65535.0 + offset;
+  LinkState state = LinkState::OK;
+  if (health.consecutiveMisses >= thresholds.lostMisses) {
+    state = LinkState::LOST;
+  } else if (health.consecutiveMisses >= thresholds.degradedMisses or health.latency > thresholds.degradedLatency) {
+    state = LinkState::DEGRADED;
   }
 
-  return pgg;
+  if (state != health.state) {
+    LinkState previous = health.state;
+    health.state = state;
+    if (linkCallback != nullptr) {
+      linkCallback(*this, previous, linkContext);
+    }
+  }
 }
 
+Motor::OutputParameters Motor::unpackReplay(const BasicTransport::CanFrame & canFrame)
+{
+  MotorCodec::State state = codec.decode(canFrame.data);
 
-
+  OutputParameters feedback;
+  feedback.timestamp = canFrame.timestamp;
+  feedback.position = state.position;
+  feedback.velocity = state.velocity;
+  feedback.torque = state.torque;
+  return feedback;
+}
@@ -3,9 +3,11 @@
 
 
 #include <array>
+#include <chrono>
 #include <optional>
 #include "dimensions/dimensions.hpp"
 #include "transport/basic_transport.hpp"
+#include "motor_codec.hpp"
 #include <stdint.h>
 #include <string>
 
@@ -61,6 +63,30 @@ public:
     MotorLimits motorHwLimits;
   };
 
+  enum class LinkState : uint8_t {
+    OK,
+    DEGRADED,
+    LOST
+  };
+
+  struct LinkThresholds {
+    uint32_t degradedMisses = 2;                     // unanswered commands in a row
+    uint32_t lostMisses = 5;
+    std::chrono::microseconds degradedLatency{1000}; // of the latency average
+    float latencyWeight = 0.1f;                      // of a new sample in the average
+  };
+
+  struct LinkHealth {
+    LinkState state = LinkState::OK;
+    BasicTransport::CanFrame::Clock::time_point lastReply; // on the time line of the transport
+    std::chrono::nanoseconds latency{0};                   // average from a command to its reply
+    uint32_t consecutiveMisses = 0;
+    uint64_t misses = 0;
+  };
+
+  // Called on every change of the link state by the thread driving the motor
+  using LinkCallback = void (*)(Motor & motor, LinkState previous, void * context);
+
 private:
   struct InputParameters {
     Radian position;
@@ -74,6 +100,7 @@ private:
     Radian position;
     AngularVelocity velocity;
     Torque torque;
+    BasicTransport::CanFrame::Clock::time_point timestamp; // of the reply reception
   };
 
 private:
@@ -82,11 +109,20 @@ private:
   uint8_t masterCanId;
 
   MotorInfo config;
+  MotorCodec codec; // scales of config.motorHwLimits
   InputParameters inputParams;
+  MotorCodec::Codes inputCodes; // of inputParams
+  MotorCodec::Codes sentCodes;  // of the last command sent
   OutputParameters outputParams;
 
   MotorState motorState = MotorState::MOTOR_MODE_NOT_ACTIVE;
 
+  LinkHealth health;
+  LinkThresholds thresholds;
+  LinkCallback linkCallback = nullptr;
+  void * linkContext = nullptr;
+  bool awaitingReply = false;
+
 public:
   Motor(BasicTransport & bus, uint8_t canId, uint8_t masterCanId, const MotorInfo & config) noexcept;
   Motor(Motor && other);
@@ -102,6 +138,31 @@ public:
   BasicTransport::Status sendToMotor();
   BasicTransport::Status getActualParameters();
 
+  // The halves of the above for a caller moving the frames itself, as
+  // MotorCycle does: the command of the input parameters, whether it
+  // belongs to the urgent lane, the unpacking of a taken reply and the
+  // notice of a command gone to the bus
+  BasicTransport::CanFrame command();
+  bool isReleasing() const;
+  BasicTransport::Status applyReply(const BasicTransport::CanFrame & canFrame);
+  void commandSent();
+
+  // Whether a setpoint changed on the wire since the last command sent,
+  // a change rounding to the same codes doesn't count. A caller may skip
+  // the unchanged commands, their replies are skipped with them.
+  bool commandChanged() const;
+
+  // Link health, judged by the replies taken by getActualParameters() or
+  // a MotorCycle: a command still unanswered when the next one is sent
+  // counts as a miss. Without taking the replies the link is soon LOST.
+  void linkThresholds(const LinkThresholds & thresholds);
+  void onLinkChange(LinkCallback callback, void * context = nullptr);
+  const LinkHealth & linkHealth() const;
+  // `now` on the time line of the transport, the steady clock but for simulations
+  std::chrono::nanoseconds timeSinceReply(
+    BasicTransport::CanFrame::Clock::time_point now = BasicTransport::CanFrame::Clock::now()
+  ) const;
+
   // InputParameters setters
   void position(Radian pos);
   void velocity(AngularVelocity vel);
@@ -114,6 +175,8 @@ public:
   uint8_t masterCanID() const;
   const BasicTransport & transport() const;
   const MotorInfo & motorInfo() const;
+  // The quantizations of the setpoints, which values the wire carries exactly
+  const MotorCodec & motorCodec() const;
 
   // State getters
   MotorState state() const;
@@ -134,34 +197,44 @@ public:
 
 private:
   // Packing/unpacking, sending/receivring
-  BasicTransport::CanFrame packCmd(const InputParameters & inParams);
+  void packCmd(const MotorCodec::Codes & codes, BasicTransport::CanFrame & canFrame);
   BasicTransport::Status sendCmd(const BasicTransport::CanFrame & canFrame);
+  BasicTransport::Status sendUrgentCmd(const BasicTransport::CanFrame & canFrame);
 
   OutputParameters unpackReplay(const BasicTransport::CanFrame & canFrame);
   std::optional<BasicTransport::CanFrame> getReply();
+  void trackReply(const BasicTransport::CanFrame & canFrame);
+  void frameSent();
+  void updateLinkState();
+  // no torque, stiffness nor damping on the wire
+  bool isLimp(const MotorCodec::Codes & codes) const;
 
-  constexpr uint32_t floatToUint(float x, float x_min, float x_max, uint8_t bits);
-  constexpr float uintToFloat(uint32_t x_int, float x_min, float x_max, uint8_t bits);
 
-  template <typename Param, typename T, typename Unit>
+  template <typename Param, typename Dimensions, unsigned Bits>
   constexpr void setParameterHelper(
     Param val,
-    dimensions::Unit<T> & inputParamsVal,
-    const Limits<Unit> & limits
+    dimensions::Unit<Dimensions> & inputParamsVal,
+    dimensions::QuantizedUnit<Dimensions, Bits> & inputCode,
+    const dimensions::Quantization<Dimensions, Bits> & quantization
   );
 };
 
-template <typename Param, typename T, typename Unit>
+template <typename Param, typename Dimensions, unsigned Bits>
 constexpr void Motor::setParameterHelper(
-  Param val, dimensions::Unit<T> & inputParamsVal, const Limits<Unit> & limits
+  Param val,
+  dimensions::Unit<Dimensions> & inputParamsVal,
+  dimensions::QuantizedUnit<Dimensions, Bits> & inputCode,
+  const dimensions::Quantization<Dimensions, Bits> & quantization
 )
 {
-  if (val == inputParamsVal) {
-    return;
-  }
-  inputParamsVal = dimensions::limitUnitBy(val, limits.min, limits.max);
+  // the codec ranges are the limits of the motor
+  inputParamsVal = dimensions::limitUnitBy(dimensions::Unit<Dimensions>(val), quantization.min(), quantization.max());
+  inputCode = quantization.quantize(inputParamsVal);
 }
 
+// The ranges of the MIT packing of a motor with the limits
+MotorCodec::Ranges codecRanges(const Motor::MotorLimits & limits);
+
 } // namespace kot_motor::motor
 
 #endif // MOTOR_HPP
@@ -0,0 +1,202 @@
+#ifndef MOTOR_CODEC_HPP
+#define MOTOR_CODEC_HPP
+
+#include <stdint.h>
+#include <algorithm>
+#include "dimensions/quantized.hpp"
+
+namespace kot_motor::motor {
+
+// Fixed-point packing of the MIT protocol. The scale and the offset of
+// every field are computed once from the limits, so encoding a value is
+// a clamp, a multiply-add and a conversion, and decoding the reverse,
+// with no division and no branch. The fields are the Quantizations of
+// their units, the codes of a command can be kept and packed later.
+class MotorCodec {
+public:
+  using PositionQuantization = dimensions::Quantization<dimensions::Radian::dimension, 16>;
+  using VelocityQuantization = dimensions::Quantization<dimensions::AngularVelocity::dimension, 12>;
+  using TorqueQuantization = dimensions::Quantization<dimensions::Torque::dimension, 12>;
+  using StiffnessQuantization = dimensions::Quantization<dimensions::RotationalStiffness::dimension, 12>;
+  using DamperQuantization = dimensions::Quantization<dimensions::RotationalDamping::dimension, 12>;
+
+  struct Range {
+    float min;
+    float max;
+  };
+
+  struct Ranges {
+    Range position;
+    Range velocity;
+    Range torque;
+    Range stiffness;
+    Range damper;
+  };
+
+  struct Command {
+    float position;
+    float velocity;
+    float stiffness;
+    float damper;
+    float torque;
+  };
+
+  struct State {
+    float position;
+    float velocity;
+    float torque;
+  };
+
+  // A command as it goes on the wire
+  struct Codes {
+    PositionQuantization::quantized position;
+    VelocityQuantization::quantized velocity;
+    StiffnessQuantization::quantized stiffness;
+    DamperQuantization::quantized damper;
+    TorqueQuantization::quantized torque;
+
+    friend constexpr bool operator==(const Codes & lhs, const Codes & rhs)
+    {
+      return lhs.position == rhs.position and lhs.velocity == rhs.velocity
+        and lhs.stiffness == rhs.stiffness and lhs.damper == rhs.damper
+        and lhs.torque == rhs.torque;
+    }
+
+    friend constexpr bool operator!=(const Codes & lhs, const Codes & rhs)
+    {
+      return !(lhs == rhs);
+    }
+  };
+
+public:
+  constexpr explicit MotorCodec(const Ranges & ranges) noexcept
+    : positionField(ranges.position.min, ranges.position.max)
+    , velocityField(ranges.velocity.min, ranges.velocity.max)
+    , torqueField(ranges.torque.min, ranges.torque.max)
+    , stiffnessField(ranges.stiffness.min, ranges.stiffness.max)
+    , damperField(ranges.damper.min, ranges.damper.max)
+  { }
+
+  // 8 bytes of command, inlined into the loops over the motors
+  constexpr void encode(const Command & command, uint8_t * data) const noexcept;
+  constexpr Codes quantize(const Command & command) const noexcept;
+  static constexpr void pack(const Codes & codes, uint8_t * data) noexcept;
+  // the 6 bytes of a reply, the first one is the motor id
+  constexpr State decode(const uint8_t * data) const noexcept;
+
+  constexpr const PositionQuantization & position() const noexcept
+  {
+    return positionField;
+  }
+
+  constexpr const VelocityQuantization & velocity() const noexcept
+  {
+    return velocityField;
+  }
+
+  constexpr const TorqueQuantization & torque() const noexcept
+  {
+    return torqueField;
+  }
+
+  constexpr const StiffnessQuantization & stiffness() const noexcept
+  {
+    return stiffnessField;
+  }
+
+  constexpr const DamperQuantization & damper() const noexcept
+  {
+    return damperField;
+  }
+
+private:
+  PositionQuantization positionField;
+  VelocityQuantization velocityField;
+  TorqueQuantization torqueField;
+  StiffnessQuantization stiffnessField;
+  DamperQuantization damperField;
+};
+
+constexpr void MotorCodec::encode(const Command & command, uint8_t * data) const noexcept
+{
+  pack(quantize(command), data);
+}
+
+constexpr MotorCodec::Codes MotorCodec::quantize(const Command & command) const noexcept
+{
+  return Codes{
+    positionField.quantize(command.position),
+    velocityField.quantize(command.velocity),
+    stiffnessField.quantize(command.stiffness),
+    damperField.quantize(command.damper),
+    torqueField.quantize(command.torque)
+  };
+}
+
+constexpr void MotorCodec::pack(const Codes & codes, uint8_t * data) noexcept
+{
+  /*
+   * CAN Command Packet Structure
+   *
+   * 16 bit position command, between -4*pi and 4*pi
+   * 12 bit velocity command, between -30 and + 30 rad/s
+   * 12 bit kp, between 0 and 500 N-m/rad
+   * 12 bit kd, between 0 and 100 N-m*s/rad
+   * 12 bit feed forward torque, between -18 and 18 N-m
+   * CAN Packet is 8 8-bit words
+   * Formatted as follows.  For each quantity, bit 0 is LSB
+   * 0: [position[15-8]]
+   * 1: [position[7-0]]
+   * 2: [velocity[11-4]]
+   * 3: [velocity[3-0], kp[11-8]]
+   * 4: [kp[7-0]]
+   * 5: [kd[11-4]]
+   * 6: [kd[3-0], torque[11-8]]
+   * 7: [torque[7-0]]
+   */
+  uint32_t p_int = codes.position.code();
+  uint32_t v_int = codes.velocity.code();
+  uint32_t kp_int = codes.stiffness.code();
+  uint32_t kd_int = codes.damper.code();
+  uint32_t t_int = codes.torque.code();
+
+  data[0] = p_int >> 8;
+  data[1] = p_int & 0xFF;
+  data[2] = v_int >> 4;
+  data[3] = ((v_int & 0xF) << 4) | (kp_int >> 8);
+  data[4] = kp_int & 0xFF;
+  data[5] = kd_int >> 4;
+  data[6] = ((kd_int & 0xF) << 4) | (t_int >> 8);
+  data[7] = t_int & 0xFF;
+}
+
+constexpr MotorCodec::State MotorCodec::decode(const uint8_t * data) const noexcept
+{
+  /*
+   * CAN Reply Packet Structure:
+   *
+   * 16 bit position, between -4*pi and 4*pi
+   * 12 bit velocity, between -30 and + 30 rad/s
+   * 12 bit current, between -40 and 40;
+   * Formatted as follows.  For each quantity, bit 0 is LSB
+   * 0: [motor id]
+   * 1: [position[15-8]]
+   * 2: [position[7-0]]
+   * 3: [velocity[11-4]]
+   * 4: [velocity[3-0], current[11-8]]
+   * 5: [current[7-0]]
+   */
+  uint32_t p_int = (data[1] << 8) | data[2];
+  uint32_t v_int = (data[3] << 4) | (data[4] >> 4);
+  uint32_t i_int = ((data[4] & 0xF) << 8) | data[5];
+
+  return State{
+    positionField.value(PositionQuantization::quantized(p_int)).value(),
+    velocityField.value(VelocityQuantization::quantized(v_int)).value(),
+    torqueField.value(TorqueQuantization::quantized(i_int)).value()
+  };
+}
+
+} // namespace kot_motor::motor
+
+#endif // MOTOR_CODEC_HPP
@@ -0,0 +1,133 @@
+#include "motor_cycle.hpp"
+
+using kot_motor::motor::MotorCycle;
+using kot_motor::transport::BasicTransport;
+
+MotorCycle::MotorCycle(BasicTransport & bus)
+  : bus(bus)
+{ }
+
+bool MotorCycle::add(Motor & motor)
+{
+  if (&motor.transport() != &bus) {
+    return false;
+  }
+
+  motors.push_back(&motor);
+  statuses.push_back(ReplyStatus::MISSING);
+  sent.push_back(false);
+  commands.emplace_back();
+  commanded.push_back(0);
+  return true;
+}
+
+size_t MotorCycle::size() const noexcept
+{
+  return motors.size();
+}
+
+BasicTransport::Status MotorCycle::send()
+{
+  // the replies already received are taken before the commands, even
+  // on transports stamping them on reading they can't pass for fresh
+  bus.receive();
+  for (Motor * motor : motors) {
+    if (auto reply = bus.takeReply(motor->canID())) {
+      motor->applyReply(reply.value());
+    }
+  }
+
+  awaiting = 0;
+  fresh = 0;
+  size_t commandsN = 0;
+  BasicTransport::Status status = BasicTransport::Status::SUCCESS;
+
+  for (size_t i = 0; i < motors.size(); i++) {
+    statuses[i] = ReplyStatus::MISSING;
+    sent[i] = false;
+
+    Motor & motor = *motors[i];
+    if (!motor.isReleasing()) {
+      commands[commandsN] = motor.command();
+      commanded[commandsN++] = i;
+    } else if (bus.writeUrgent(motor.command()) == BasicTransport::Status::SUCCESS) {
+      // going limp, an unsent mode frame of the motor still goes first
+      motor.commandSent();
+      sent[i] = true;
+      awaiting++;
+    } else {
+      status = BasicTransport::Status::FAIL;
+    }
+  }
+
+  size_t written = bus.writeBatch(commands.data(), commandsN);
+  for (size_t k = 0; k < written; k++) {
+    motors[commanded[k]]->commandSent();
+    sent[commanded[k]] = true;
+  }
+  awaiting += written;
+
+  if (written < commandsN) {
+    status = BasicTransport::Status::FAIL;
+  }
+  return status;
+}
+
+BasicTransport::Status MotorCycle::collect(Clock::time_point deadline)
+{
+  takeReplies();
+  while (awaiting > 0) {
+    auto now = bus.now();
+    if (now >= deadline) {
+      break;
+    }
+    bus.wait(std::chrono::ceil<std::chrono::microseconds>(deadline - now));
+    takeReplies();
+  }
+
+  return fresh == motors.size() ? BasicTransport::Status::SUCCESS : BasicTransport::Status::FAIL;
+}
+
+BasicTransport::Status MotorCycle::run(std::chrono::microseconds timeout)
+{
+  BasicTransport::Status sendStatus = send();
+  BasicTransport::Status collectStatus = collect(bus.now() + timeout);
+  return sendStatus == BasicTransport::Status::SUCCESS ? collectStatus : sendStatus;
+}
+
+MotorCycle::ReplyStatus MotorCycle::status(size_t i) const
+{
+  return statuses.at(i);
+}
+
+size_t MotorCycle::freshCount() const noexcept
+{
+  return fresh;
+}
+
+/********************************* Internals *********************************/
+
+void MotorCycle::takeReplies() noexcept
+{
+  bus.receive();
+
+  for (size_t i = 0; i < motors.size(); i++) {
+    if (!sent[i] or statuses[i] == ReplyStatus::FRESH) {
+      continue;
+    }
+
+    Motor & motor = *motors[i];
+    auto reply = bus.takeReply(motor.canID());
+    if (!reply.has_value() or motor.applyReply(reply.value()) != BasicTransport::Status::SUCCESS) {
+      continue;
+    }
+
+    if (bus.answersLatestCommand(motor.canID(), reply.value())) {
+      statuses[i] = ReplyStatus::FRESH;
+      fresh++;
+      awaiting--;
+    } else {
+      statuses[i] = ReplyStatus::STALE;
+    }
+  }
+}
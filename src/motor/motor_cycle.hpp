@@ -0,0 +1,65 @@
+#ifndef MOTOR_CYCLE_HPP
+#define MOTOR_CYCLE_HPP
+
+#include <chrono>
+#include <vector>
+#include "motor.hpp"
+
+namespace kot_motor::motor {
+
+// One control cycle over the motors of a bus. The firmware answers every
+// command with its state, so the commands of all the motors go out back
+// to back and their replies are then awaited together until a single
+// deadline: one round trip per cycle instead of one per motor.
+// The motors are added once, a cycle doesn't allocate.
+class MotorCycle {
+public:
+  using Clock = BasicTransport::CanFrame::Clock;
+
+  enum class ReplyStatus : uint8_t {
+    FRESH,  // answered the command of this cycle
+    STALE,  // only a reply older than the command of this cycle came
+    MISSING // nothing came
+  };
+
+public:
+  MotorCycle(BasicTransport & bus);
+
+  // The motor has to be on the bus of the cycle, returns false otherwise
+  bool add(Motor & motor);
+  size_t size() const noexcept;
+
+  // Sends the commands of all the motors, the ones going limp by the
+  // urgent lane, which keeps an unsent mode frame of the motor ahead of
+  // them. FAIL if some could not be sent, they are MISSING then.
+  BasicTransport::Status send();
+  // Applies the replies to the motors as they come, until each motor
+  // answered or the deadline passes. SUCCESS if all of them are FRESH.
+  // The deadline is on the time line of the bus (BasicTransport::now()),
+  // a simulated bus spends no more than the timeout of its own time.
+  BasicTransport::Status collect(Clock::time_point deadline);
+  // send() and collect() with the deadline `timeout` after the sending
+  BasicTransport::Status run(std::chrono::microseconds timeout);
+
+  // The outcome of the last cycle
+  ReplyStatus status(size_t i) const;
+  size_t freshCount() const noexcept;
+
+private:
+  void takeReplies() noexcept;
+
+private:
+  BasicTransport & bus;
+  std::vector<Motor *> motors;
+  std::vector<ReplyStatus> statuses;
+  std::vector<bool> sent; // the command of this cycle went to the bus
+  std::vector<BasicTransport::CanFrame> commands;
+  std::vector<size_t> commanded; // indices of the motors in `commands`
+
+  size_t awaiting = 0;
+  size_t fresh = 0;
+};
+
+} // namespace kot_motor::motor
+
+#endif // MOTOR_CYCLE_HPP
@@ -0,0 +1,298 @@
+#include <endian.h>
+#include <cstring>
+#include "motor_group.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using kot_motor::motor::MotorGroup;
+using kot_motor::transport::BasicTransport;
+
+namespace {
+
+// The few vector operations of the packing. max() returns its second
+// operand for a NaN in the first, so a NaN setpoint clamps to the
+// minimum as it would in every lane width.
+#if defined(__AVX2__)
+
+struct Simd {
+  static constexpr size_t WIDTH = 8;
+  using F = __m256;
+  using I = __m256i;
+
+  static F load(const float * p) { return _mm256_loadu_ps(p); }
+  static void store(int32_t * p, I v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+  static F max(F a, F b) { return _mm256_max_ps(a, b); }
+  static F min(F a, F b) { return _mm256_min_ps(a, b); }
+  static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+  static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+  static I truncate(F v) { return _mm256_cvttps_epi32(v); }
+  static I bitOr(I a, I b) { return _mm256_or_si256(a, b); }
+  template <int n> static I shiftLeft(I v) { return _mm256_slli_epi32(v, n); }
+  template <int n> static I shiftRight(I v) { return _mm256_srli_epi32(v, n); }
+};
+
+#elif defined(__SSE2__)
+
+struct Simd {
+  static constexpr size_t WIDTH = 4;
+  using F = __m128;
+  using I = __m128i;
+
+  static F load(const float * p) { return _mm_loadu_ps(p); }
+  static void store(int32_t * p, I v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+  static F max(F a, F b) { return _mm_max_ps(a, b); }
+  static F min(F a, F b) { return _mm_min_ps(a, b); }
+  static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+  static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+  static I truncate(F v) { return _mm_cvttps_epi32(v); }
+  static I bitOr(I a, I b) { return _mm_or_si128(a, b); }
+  template <int n> static I shiftLeft(I v) { return _mm_slli_epi32(v, n); }
+  template <int n> static I shiftRight(I v) { return _mm_srli_epi32(v, n); }
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+struct Simd {
+  static constexpr size_t WIDTH = 4;
+  using F = float32x4_t;
+  using I = int32x4_t;
+
+  static F load(const float * p) { return vld1q_f32(p); }
+  static void store(int32_t * p, I v) { vst1q_s32(p, v); }
+  static F max(F a, F b) { return vmaxnmq_f32(a, b); }
+  static F min(F a, F b) { return vminnmq_f32(a, b); }
+  static F sub(F a, F b) { return vsubq_f32(a, b); }
+  static F mul(F a, F b) { return vmulq_f32(a, b); }
+  static I truncate(F v) { return vcvtq_s32_f32(v); }
+  static I bitOr(I a, I b) { return vorrq_s32(a, b); }
+  template <int n> static I shiftLeft(I v) { return vshlq_n_s32(v, n); }
+  template <int n> static I shiftRight(I v) { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(v), n)); }
+};
+
+#else
+
+struct Simd {
+  static constexpr size_t WIDTH = 1;
+  using F = float;
+  using I = int32_t;
+
+  static F load(const float * p) { return *p; }
+  static void store(int32_t * p, I v) { *p = v; }
+  static F max(F a, F b) { return a > b ? a : b; }
+  static F min(F a, F b) { return a < b ? a : b; }
+  static F sub(F a, F b) { return a - b; }
+  static F mul(F a, F b) { return a * b; }
+  static I truncate(F v) { return I(v); }
+  static I bitOr(I a, I b) { return a | b; }
+  template <int n> static I shiftLeft(I v) { return I(uint32_t(v) << n); }
+  template <int n> static I shiftRight(I v) { return I(uint32_t(v) >> n); }
+};
+
+#endif
+
+static_assert(MotorGroup::LANES % Simd::WIDTH == 0);
+
+// The arrays of a setpoint, read through local pointers: the vector
+// stores may alias anything, the members would be reloaded after each
+struct Quantizer {
+  const float * values;
+  const float * min;
+  const float * max;
+  const float * toCode;
+
+  template <typename Setpoint>
+  explicit Quantizer(const Setpoint & setpoint) noexcept
+    : values(setpoint.values.data())
+    , min(setpoint.field.min.data())
+    , max(setpoint.field.max.data())
+    , toCode(setpoint.field.toCode.data())
+  { }
+
+  // the codes of the motors i to i + Simd::WIDTH
+  Simd::I operator()(size_t i) const noexcept
+  {
+    Simd::F lo = Simd::load(min + i);
+    Simd::F v = Simd::min(Simd::max(Simd::load(values + i), lo), Simd::load(max + i));
+    return Simd::truncate(Simd::mul(Simd::sub(v, lo), Simd::load(toCode + i)));
+  }
+};
+
+} // namespace
+
+MotorGroup::MotorGroup()
+{
+  indices.fill(-1);
+}
+
+size_t MotorGroup::add(uint8_t canId, const MotorCodec::Ranges & ranges)
+{
+  size_t i = indices[canId] >= 0 ? size_t(indices[canId]) : canIds.size();
+  if (i == canIds.size()) {
+    canIds.push_back(canId);
+    indices[canId] = int16_t(i);
+    resize((canIds.size() + LANES - 1) / LANES * LANES);
+  }
+
+  // the scales of MotorCodec
+  auto set = [i](Field & field, const MotorCodec::Range & range, unsigned bits) {
+    float steps = float((1u << bits) - 1);
+    field.min[i] = range.min;
+    field.max[i] = range.max;
+    field.toCode[i] = range.max > range.min ? steps / (range.max - range.min) : 0.0f;
+    field.toValue[i] = (range.max - range.min) / steps;
+  };
+  set(position.field, ranges.position, 16);
+  set(velocity.field, ranges.velocity, 12);
+  set(torque.field, ranges.torque, 12);
+  set(stiffness.field, ranges.stiffness, 12);
+  set(damper.field, ranges.damper, 12);
+  return i;
+}
+
+size_t MotorGroup::add(const Motor & motor)
+{
+  return add(motor.canID(), codecRanges(motor.motorInfo().motorHwLimits));
+}
+
+size_t MotorGroup::size() const noexcept
+{
+  return canIds.size();
+}
+
+float * MotorGroup::positions() noexcept
+{
+  return position.values.data();
+}
+
+float * MotorGroup::velocities() noexcept
+{
+  return velocity.values.data();
+}
+
+float * MotorGroup::torques() noexcept
+{
+  return torque.values.data();
+}
+
+float * MotorGroup::stiffnesses() noexcept
+{
+  return stiffness.values.data();
+}
+
+float * MotorGroup::dampers() noexcept
+{
+  return damper.values.data();
+}
+
+const float * MotorGroup::actualPositions() const noexcept
+{
+  return actualPosition.data();
+}
+
+const float * MotorGroup::actualVelocities() const noexcept
+{
+  return actualVelocity.data();
+}
+
+const float * MotorGroup::actualTorques() const noexcept
+{
+  return actualTorque.data();
+}
+
+void MotorGroup::encode(BasicTransport::CanFrame * frames) noexcept
+{
+  // the layout of MotorCodec::encode, the 64 bits of a command are
+  // the codes one after the other from the most significant
+  const Quantizer p_codes(position);
+  const Quantizer v_codes(velocity);
+  const Quantizer kp_codes(stiffness);
+  const Quantizer kd_codes(damper);
+  const Quantizer t_codes(torque);
+  int32_t * highs = high.data();
+  int32_t * lows = low.data();
+  size_t padded = high.size();
+
+  for (size_t i = 0; i < padded; i += Simd::WIDTH) {
+    Simd::I p_int = p_codes(i);
+    Simd::I v_int = v_codes(i);
+    Simd::I kp_int = kp_codes(i);
+    Simd::I kd_int = kd_codes(i);
+    Simd::I t_int = t_codes(i);
+
+    Simd::store(highs + i, Simd::bitOr(
+      Simd::bitOr(Simd::shiftLeft<16>(p_int), Simd::shiftLeft<4>(v_int)), Simd::shiftRight<8>(kp_int)
+    ));
+    Simd::store(lows + i, Simd::bitOr(
+      Simd::bitOr(Simd::shiftLeft<24>(kp_int), Simd::shiftLeft<12>(kd_int)), t_int
+    ));
+  }
+
+  const uint8_t * ids = canIds.data();
+  size_t motorsN = canIds.size();
+  for (size_t i = 0; i < motorsN; i++) {
+    uint32_t words[2] = {htobe32(uint32_t(highs[i])), htobe32(uint32_t(lows[i]))};
+
+    BasicTransport::CanFrame & frame = frames[i];
+    frame.canId = ids[i];
+    frame.size = 8;
+    std::memcpy(frame.data, words, sizeof(words));
+  }
+}
+
+size_t MotorGroup::decode(const BasicTransport::CanFrame * replies, size_t count) noexcept
+{
+  // The replies come in any order, each is scattered to its motor. The
+  // codes are converted right away: a vector pass over the codes just
+  // stored one by one would wait on the forwarding of every store.
+  float * positions = actualPosition.data();
+  float * velocities = actualVelocity.data();
+  float * torques = actualTorque.data();
+  const float * p_min = position.field.min.data();
+  const float * p_scale = position.field.toValue.data();
+  const float * v_min = velocity.field.min.data();
+  const float * v_scale = velocity.field.toValue.data();
+  const float * t_min = torque.field.min.data();
+  const float * t_scale = torque.field.toValue.data();
+  size_t taken = 0;
+
+  for (size_t k = 0; k < count; k++) {
+    const uint8_t * data = replies[k].data;
+    int16_t i = indices[data[0]];
+    if (i < 0 or replies[k].size < 6) {
+      continue;
+    }
+
+    // the layout of MotorCodec::decode
+    uint32_t p_int = (data[1] << 8) | data[2];
+    uint32_t v_int = (data[3] << 4) | (data[4] >> 4);
+    uint32_t i_int = ((data[4] & 0xF) << 8) | data[5];
+
+    positions[i] = float(p_int) * p_scale[i] + p_min[i];
+    velocities[i] = float(v_int) * v_scale[i] + v_min[i];
+    torques[i] = float(i_int) * t_scale[i] + t_min[i];
+    taken++;
+  }
+  return taken;
+}
+
+void MotorGroup::resize(size_t padded)
+{
+  for (Setpoint * setpoint : {&position, &velocity, &torque, &stiffness, &damper}) {
+    setpoint->values.resize(padded, 0.0f);
+    setpoint->field.min.resize(padded, 0.0f);
+    setpoint->field.max.resize(padded, 0.0f);
+    setpoint->field.toCode.resize(padded, 0.0f);
+    setpoint->field.toValue.resize(padded, 0.0f);
+  }
+  actualPosition.resize(padded, 0.0f);
+  actualVelocity.resize(padded, 0.0f);
+  actualTorque.resize(padded, 0.0f);
+  high.resize(padded, 0);
+  low.resize(padded, 0);
+}
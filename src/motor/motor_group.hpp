@@ -0,0 +1,86 @@
+#ifndef MOTOR_GROUP_HPP
+#define MOTOR_GROUP_HPP
+
+#include <array>
+#include <vector>
+#include "motor.hpp"
+#include "motor_codec.hpp"
+
+namespace kot_motor::motor {
+
+// The setpoints and the states of many motors in contiguous arrays, one
+// per quantity, so the MIT packing of a whole robot runs over them with
+// vector instructions (AVX2, SSE2 or NEON, whichever the build targets,
+// a scalar loop otherwise), LANES motors at a time. The arrays are
+// padded to a multiple of LANES, the padding motors encode to zero.
+// The commands are the ones MotorCodec encodes, byte for byte. The
+// replies come in any order and are scattered to their motors.
+// The mode frames stay with Motor, the group only carries setpoints.
+class MotorGroup {
+public:
+  static constexpr size_t LANES = 8;
+
+public:
+  MotorGroup();
+
+  // Returns the index of the motor in the arrays
+  size_t add(uint8_t canId, const MotorCodec::Ranges & ranges);
+  size_t add(const Motor & motor);
+  size_t size() const noexcept;
+
+  // Setpoints, size() of each
+  float * positions() noexcept;
+  float * velocities() noexcept;
+  float * torques() noexcept;
+  float * stiffnesses() noexcept;
+  float * dampers() noexcept;
+
+  // The state of the last decoded replies, zero until a motor answers
+  const float * actualPositions() const noexcept;
+  const float * actualVelocities() const noexcept;
+  const float * actualTorques() const noexcept;
+
+  // Fills `frames`, size() of them, with the commands of the setpoints
+  void encode(BasicTransport::CanFrame * frames) noexcept;
+  // Updates the state of the motors answering, the replies of other
+  // motors are skipped. Returns the number of replies taken.
+  size_t decode(const BasicTransport::CanFrame * replies, size_t count) noexcept;
+
+private:
+  // the scales of a quantity of the protocol, for every motor
+  struct Field {
+    std::vector<float> min;
+    std::vector<float> max;
+    std::vector<float> toCode;
+    std::vector<float> toValue;
+  };
+
+  struct Setpoint {
+    std::vector<float> values;
+    Field field;
+  };
+
+  void resize(size_t padded);
+
+private:
+  std::vector<uint8_t> canIds;
+  std::array<int16_t, 256> indices; // by motor id, -1 if not in the group
+
+  Setpoint position;
+  Setpoint velocity;
+  Setpoint torque;
+  Setpoint stiffness;
+  Setpoint damper;
+
+  // the halves of the commands, as MotorCodec lays them out
+  std::vector<int32_t> high;
+  std::vector<int32_t> low;
+
+  std::vector<float> actualPosition;
+  std::vector<float> actualVelocity;
+  std::vector<float> actualTorque;
+};
+
+} // namespace kot_motor::motor
+
+#endif // MOTOR_GROUP_HPP
@@ -0,0 +1,35 @@
+#ifndef STATIC_CODEC_HPP
+#define STATIC_CODEC_HPP
+
+#include "motor_codec.hpp"
+
+namespace kot_motor::motor {
+
+// MotorCodec of a motor model known at compile time, the Model provides
+// `static constexpr MotorCodec::Ranges ranges` (see config::model). The
+// scales, offsets and clamping bounds are constants, so encode() and
+// decode() fold into immediates, as the hand-written packing of one
+// model would. It measures no faster than MotorCodec though (see the
+// motor_codec benchmark): a loop keeps the runtime scales in registers
+// as well, the conversions and the stores are what the packing costs.
+// Motor keeps the codec configured at run time.
+template <typename Model>
+class StaticCodec {
+public:
+  static constexpr MotorCodec codec{Model::ranges};
+
+public:
+  static constexpr void encode(const MotorCodec::Command & command, uint8_t * data) noexcept
+  {
+    codec.encode(command, data);
+  }
+
+  static constexpr MotorCodec::State decode(const uint8_t * data) noexcept
+  {
+    return codec.decode(data);
+  }
+};
+
+} // namespace kot_motor::motor
+
+#endif // STATIC_CODEC_HPP
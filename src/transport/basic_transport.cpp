@@ -2,19 +2,312 @@
 #include "basic_transport.hpp"
 
 using kot_motor::transport::BasicTransport;
+using kot_motor::transport::BusLoad;
 
-BasicTransport::CanFrame::CanFrame() = default;
+BasicTransport::CanFrame::CanFrame()
+  : canId(0), size(0), pad(0), res0(0), len8Dlc(0), data(), timestamp()
+{ }
 
-BasicTransport::~BasicTransport() = default;
+BasicTransport::~BasicTransport()
+{
+  for (auto && slot : replies) {
+    delete slot.stats.load(std::memory_order_relaxed);
+  }
+}
 
 BasicTransport::CanFrame::CanFrame(
-  uint8_t canId, uint8_t masterCanId, const uint8_t * data, uint8_t size
+  uint32_t canId, const uint8_t * data, uint8_t size
 )
-  : canId(canId), masterCanId(masterCanId), data(), size(size)
+  : canId(canId), size(size), pad(0), res0(0), len8Dlc(0), data(), timestamp()
 {
   std::memcpy(this->data, data, size);
 }
 
+size_t BasicTransport::writeBatch(const CanFrame * canFrames, size_t count)
+{
+  size_t sent = 0;
+  while (sent < count and write(canFrames[sent]) == Status::SUCCESS) {
+    sent++;
+  }
+  return sent;
+}
 
+size_t BasicTransport::readBatch(CanFrame * canFrames, size_t count)
+{
+  size_t received = 0;
+  while (received < count) {
+    auto canFrame = read();
+    if (!canFrame.has_value()) {
+      break;
+    }
+    canFrames[received++] = canFrame.value();
+  }
+  return received;
+}
 
+BasicTransport::Status BasicTransport::writeUrgent(const CanFrame & canFrame)
+{
+  return write(canFrame);
+}
+
+bool BasicTransport::wait(std::chrono::microseconds)
+{
+  return true;
+}
 
+std::optional<int> BasicTransport::descriptor() const noexcept
+{
+  return {};
+}
+
+BasicTransport::CanFrame::Clock::time_point BasicTransport::now() const noexcept
+{
+  return CanFrame::Clock::now();
+}
+
+/**************************** Reply demultiplexing ****************************/
+
+void BasicTransport::attachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  ReplySlot & slot = replies[canId];
+  if (slot.users == 0) {
+    slot.fresh = false;
+    slot.awaitingReply.store(false, std::memory_order_relaxed);
+  }
+  if (slot.stats.load(std::memory_order_relaxed) == nullptr) {
+    slot.stats.store(new TransportStats(), std::memory_order_release);
+  }
+  slot.masterCanId = masterCanId;
+  slot.users++;
+}
+
+void BasicTransport::detachMotor(uint8_t canId, uint8_t) noexcept
+{
+  ReplySlot & slot = replies[canId];
+  if (slot.users > 0) {
+    slot.users--;
+  }
+}
+
+size_t BasicTransport::receive()
+{
+  std::array<CanFrame, 32> canFrames;
+  size_t routed = 0;
+  size_t received = 0;
+  do {
+    received = readBatch(canFrames.data(), canFrames.size());
+    for (size_t i = 0; i < received; i++) {
+      routed += route(canFrames[i]);
+    }
+  } while (received == canFrames.size());
+  return routed;
+}
+
+std::optional<BasicTransport::CanFrame> BasicTransport::takeReply(uint8_t canId) noexcept
+{
+  ReplySlot & slot = replies[canId];
+  if (!slot.fresh) {
+    return {};
+  }
+  slot.fresh = false;
+  return slot.frame;
+}
+
+bool BasicTransport::hasFreshReply(uint8_t canId) const noexcept
+{
+  const ReplySlot & slot = replies[canId];
+  return slot.fresh and answersLatestCommand(canId, slot.frame);
+}
+
+bool BasicTransport::answersLatestCommand(uint8_t canId, const CanFrame & reply) const noexcept
+{
+  return reply.timestamp == CanFrame::Clock::time_point()
+    or reply.timestamp >= replies[canId].lastCommand.load(std::memory_order_acquire);
+}
+
+BasicTransport::CanFrame::Clock::time_point BasicTransport::lastCommandTime(uint8_t canId) const noexcept
+{
+  return replies[canId].lastCommand.load(std::memory_order_acquire);
+}
+
+void BasicTransport::beginAwaiting() noexcept
+{
+  commanded.reset();
+  answered.reset();
+  awaiting = 0;
+}
+
+void BasicTransport::awaitReply(uint32_t canId) noexcept
+{
+  if (canId < commanded.size() and !commanded[canId]) {
+    commanded.set(canId);
+    awaiting++;
+  }
+}
+
+size_t BasicTransport::collectAnswers() noexcept
+{
+  for (size_t canId = 0; canId < commanded.size() and awaiting > 0; canId++) {
+    if (commanded[canId] and !answered[canId] and hasFreshReply(uint8_t(canId))) {
+      answered.set(canId);
+      awaiting--;
+    }
+  }
+  return awaiting;
+}
+
+size_t BasicTransport::awaitedReplies() const noexcept
+{
+  return awaiting;
+}
+
+bool BasicTransport::route(const CanFrame & canFrame) noexcept
+{
+  if (canFrame.size == 0) {
+    return false;
+  }
+
+  ReplySlot & slot = replies[canFrame.data[0]];
+  if (slot.users == 0 or slot.masterCanId != canFrame.canId) {
+    return false;
+  }
+
+  TransportStats * motorStats = slot.stats.load(std::memory_order_relaxed);
+  motorStats->countReceived(1);
+
+  // only the freshest reply is kept, an older one is overwritten
+  if (slot.fresh) {
+    stats.countDroppedReply();
+    motorStats->countDroppedReply();
+  }
+  slot.frame = canFrame;
+  slot.fresh = true;
+
+  // the timings need a stamped frame
+  if (canFrame.timestamp == CanFrame::Clock::time_point()) {
+    return true;
+  }
+
+  if (slot.lastReply != CanFrame::Clock::time_point()) {
+    auto gap = canFrame.timestamp - slot.lastReply;
+    stats.recordReplyGap(gap);
+    motorStats->recordReplyGap(gap);
+  }
+  slot.lastReply = canFrame.timestamp;
+
+  // a reply received before the latest command answers an older one
+  auto lastCommand = slot.lastCommand.load(std::memory_order_acquire);
+  if (canFrame.timestamp < lastCommand) {
+    stats.countStaleReply();
+    motorStats->countStaleReply();
+  } else if (slot.awaitingReply.exchange(false, std::memory_order_relaxed)) {
+    auto roundTrip = canFrame.timestamp - lastCommand;
+    stats.recordRoundTrip(roundTrip);
+    motorStats->recordRoundTrip(roundTrip);
+  }
+  return true;
+}
+
+/******************************** Statistics ********************************/
+
+kot_motor::transport::TransportStats::Snapshot BasicTransport::statistics() const noexcept
+{
+  return stats.snapshot();
+}
+
+std::optional<kot_motor::transport::TransportStats::Snapshot>
+  BasicTransport::motorStatistics(uint8_t canId) const noexcept
+{
+  const TransportStats * motorStats = replies[canId].stats.load(std::memory_order_acquire);
+  if (motorStats == nullptr) {
+    return {};
+  }
+  return motorStats->snapshot();
+}
+
+/******************************** Bus timing *********************************/
+
+void BasicTransport::bitrate(uint32_t bitsPerSecond) noexcept
+{
+  this->bitsPerSecond = bitsPerSecond;
+}
+
+BusLoad BasicTransport::busLoad() const noexcept
+{
+  return BusLoad(bitsPerSecond);
+}
+
+std::chrono::nanoseconds BasicTransport::frameTime() const noexcept
+{
+  return busLoad().exchangeTime();
+}
+
+void BasicTransport::countSent(const CanFrame * canFrames, size_t count) noexcept
+{
+  if (count > 0) {
+    countSent(canFrames, count, CanFrame::Clock::now());
+  }
+}
+
+void BasicTransport::countSent(const CanFrame * canFrames, size_t count, CanFrame::Clock::time_point sentAt) noexcept
+{
+  if (count == 0) {
+    return;
+  }
+  stats.countSent(count);
+
+  for (size_t i = 0; i < count; i++) {
+    if (canFrames[i].canId >= replies.size()) {
+      continue;
+    }
+    ReplySlot & slot = replies[canFrames[i].canId];
+    TransportStats * motorStats = slot.stats.load(std::memory_order_relaxed);
+    if (motorStats != nullptr) {
+      motorStats->countSent(1);
+      slot.lastCommand.store(sentAt, std::memory_order_release);
+      slot.awaitingReply.store(true, std::memory_order_relaxed);
+    }
+  }
+}
+
+void BasicTransport::countWriteFailures(const CanFrame * canFrames, size_t count) noexcept
+{
+  if (count == 0) {
+    return;
+  }
+  stats.countWriteFailures(count);
+
+  for (size_t i = 0; i < count; i++) {
+    if (canFrames[i].canId >= replies.size()) {
+      continue;
+    }
+    TransportStats * motorStats = replies[canFrames[i].canId].stats.load(std::memory_order_relaxed);
+    if (motorStats != nullptr) {
+      motorStats->countWriteFailures(1);
+    }
+  }
+}
+
+void BasicTransport::countBackpressure(const CanFrame & canFrame) noexcept
+{
+  stats.countBackpressure();
+
+  if (canFrame.canId < replies.size()) {
+    TransportStats * motorStats = replies[canFrame.canId].stats.load(std::memory_order_relaxed);
+    if (motorStats != nullptr) {
+      motorStats->countBackpressure();
+    }
+  }
+}
+
+void BasicTransport::countReceived(size_t count) noexcept
+{
+  if (count > 0) {
+    stats.countReceived(count);
+  }
+}
+
+void BasicTransport::countErrorFrame() noexcept
+{
+  stats.countErrorFrame();
+}
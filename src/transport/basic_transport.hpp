@@ -2,7 +2,14 @@
 #define BASIC_TRANSPORT_HPP
 
 #include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
 #include <optional>
+#include "transport_stats.hpp"
+#include "bus_load.hpp"
 
 namespace kot_motor::transport {
 
@@ -15,17 +22,23 @@ public:
     SUCCESS_INIT
   };
 
+  // The first 16 bytes have the layout of the linux struct can_frame,
+  // so frames are handed to the kernel and filled by it without copying.
   struct CanFrame {
-    uint8_t canId;
-    uint8_t masterCanId;
-    uint8_t data[8]; // TODO default size == 8 ?
+    using Clock = std::chrono::steady_clock;
+
+    uint32_t canId; // on the wire: the motor id for commands, the master id for replies
     uint8_t size;
+    uint8_t pad;
+    uint8_t res0;
+    uint8_t len8Dlc;
+    alignas(8) uint8_t data[8];
+    Clock::time_point timestamp; // of the reception, for received frames
 
     CanFrame();
 
     CanFrame(
-      uint8_t canId,
-      uint8_t masterCanId,
+      uint32_t canId,
       const uint8_t * data,
       uint8_t size = 8
     );
@@ -35,8 +48,120 @@ public:
   virtual ~BasicTransport();
   virtual Status write(const CanFrame & canFrame) = 0;
   virtual std::optional<CanFrame> read() = 0;
+
+  // Batched transfer, returns the number of frames written or read.
+  // The default implementation loops over write() and read().
+  virtual size_t writeBatch(const CanFrame * canFrames, size_t count);
+  virtual size_t readBatch(CanFrame * canFrames, size_t count);
+
+  // Frames which must not wait behind the regular commands: the exit of
+  // the motor mode and the zero torque ones. Supersede the unsent regular
+  // command of the same motor, never an unsent mode frame, which still
+  // goes out first. The default implementation is write().
+  virtual Status writeUrgent(const CanFrame & canFrame);
+
+  // Blocks until a frame could be read or the timeout expires.
+  // Transports without a notion of readiness return immediately.
+  virtual bool wait(std::chrono::microseconds timeout);
+  // A descriptor polling readable when a frame could be read, to wait on
+  // the transport along with other events, after a wait() with no
+  // timeout which flushes what the transport holds. None by default.
+  virtual std::optional<int> descriptor() const noexcept;
+  // The time line of the transport, the one its timestamps and wait()
+  // go by: the steady clock but for the simulated buses
+  virtual CanFrame::Clock::time_point now() const noexcept;
+
+  // Motor registration, a motor gets its replies routed by its can id
+  virtual void attachMotor(uint8_t canId, uint8_t masterCanId) noexcept;
+  virtual void detachMotor(uint8_t canId, uint8_t masterCanId) noexcept;
+
+  // Drains all the pending frames into the reply table,
+  // returns the number of frames routed to attached motors
+  size_t receive();
+
+  // Takes the freshest not yet taken reply of the motor
+  std::optional<CanFrame> takeReply(uint8_t canId) noexcept;
+  // Whether that reply answers the latest command, leaving it in place
+  bool hasFreshReply(uint8_t canId) const noexcept;
+
+  // Whether a reply of the motor came after its latest command, by the
+  // time line of the transport. Replies without a timestamp pass.
+  bool answersLatestCommand(uint8_t canId, const CanFrame & reply) const noexcept;
+  CanFrame::Clock::time_point lastCommandTime(uint8_t canId) const noexcept;
+
+  // Statistics of the transport and of an attached motor, updated by
+  // the thread driving the transport, readable from any thread
+  TransportStats::Snapshot statistics() const noexcept;
+  std::optional<TransportStats::Snapshot> motorStatistics(uint8_t canId) const noexcept;
+
+  // Timing of the bus, the bitrate is the one the interface is configured
+  // with. frameTime() is the bus time of one motor update, a command and
+  // its reply. The wrapping transports report the ones of the wrapped bus.
+  virtual void bitrate(uint32_t bitsPerSecond) noexcept;
+  virtual BusLoad busLoad() const noexcept;
+  virtual std::chrono::nanoseconds frameTime() const noexcept;
+
+protected:
+  bool route(const CanFrame & canFrame) noexcept;
+
+  // The replies a cycle of a bus group waits for: one per motor commanded,
+  // however many frames it was sent or sends back. Only the first fresh
+  // reply of a motor counts, the replies stay in place for the motors.
+  void beginAwaiting() noexcept;
+  void awaitReply(uint32_t canId) noexcept;
+  // returns the number of replies still awaited
+  size_t collectAnswers() noexcept;
+  size_t awaitedReplies() const noexcept;
+
+  // Accounting of the frames, done by the transports themselves.
+  // The commands carry the motor id, which starts their round trip.
+  void countSent(const CanFrame * canFrames, size_t count) noexcept;
+  // for the transports with a time line of their own
+  void countSent(const CanFrame * canFrames, size_t count, CanFrame::Clock::time_point sentAt) noexcept;
+  void countWriteFailures(const CanFrame * canFrames, size_t count) noexcept;
+  void countBackpressure(const CanFrame & canFrame) noexcept;
+  void countReceived(size_t count) noexcept;
+  void countErrorFrame() noexcept;
+
+private:
+  struct ReplySlot {
+    uint8_t users = 0;
+    uint8_t masterCanId = 0;
+    bool fresh = false;
+    CanFrame frame;
+
+    // set by the send side, taken by the receive side, which may be
+    // another thread
+    std::atomic<bool> awaitingReply{false};
+    std::atomic<CanFrame::Clock::time_point> lastCommand{CanFrame::Clock::time_point()};
+    CanFrame::Clock::time_point lastReply;
+    // allocated by the first attach, kept while the transport lives
+    std::atomic<TransportStats *> stats{nullptr};
+  };
+
+  // indexed by the motor id, which is the first byte of every reply
+  std::array<ReplySlot, 256> replies;
+  // the motors commanded by the cycle and the ones which answered
+  std::bitset<256> commanded;
+  std::bitset<256> answered;
+  size_t awaiting = 0;
+  TransportStats stats;
+  uint32_t bitsPerSecond = BusLoad::DEFAULT_BITRATE;
 };
 
+// The enter/exit motor mode and set zero frames, which must reach the
+// motor even when followed by a command right away: they are never
+// coalesced with nor superseded by the later frames of their motor
+inline bool isModeFrame(const BasicTransport::CanFrame & canFrame) noexcept
+{
+  for (size_t i = 0; i < 7; i++) {
+    if (canFrame.data[i] != 0xFF) {
+      return false;
+    }
+  }
+  return canFrame.size == 8 and canFrame.data[7] >= 0xFC and canFrame.data[7] <= 0xFE;
+}
+
 } // namespace kot_motor::transport
 
 #endif // BASIC_TRANSPORT_HPP
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include "bus_group.hpp"
+
+using kot_motor::transport::BusGroup;
+
+BusGroup::BusGroup(const std::vector<std::string> & canNames)
+{
+  buses.reserve(canNames.size());
+  for (auto && canName : canNames) {
+    buses.push_back(std::make_unique<Bus>(canName));
+  }
+  pfds.reserve(canNames.size());
+}
+
+BusGroup::~BusGroup() = default;
+
+BusGroup::Status BusGroup::open()
+{
+  for (auto && bus : buses) {
+    if (bus->socket.open() != Status::SUCCESS_INIT) {
+      close();
+      return Status::FAIL;
+    }
+  }
+  return Status::SUCCESS_INIT;
+}
+
+BusGroup::Status BusGroup::close()
+{
+  for (auto && bus : buses) {
+    if (bus->socket.descriptor().has_value()) {
+      bus->socket.close();
+    }
+  }
+  return Status::SUCCESS;
+}
+
+size_t BusGroup::size() const noexcept
+{
+  return buses.size();
+}
+
+kot_motor::transport::BasicTransport & BusGroup::bus(size_t i)
+{
+  return *buses.at(i);
+}
+
+kot_motor::transport::SocketCanTransport & BusGroup::socket(size_t i)
+{
+  return buses.at(i)->socket;
+}
+
+/*********************************** Cycle ***********************************/
+
+void BusGroup::beginCycle() noexcept
+{
+  for (auto && bus : buses) {
+    bus->deferred = true;
+  }
+}
+
+BusGroup::Status BusGroup::send()
+{
+  // one sendmmsg per bus, the adapters then transmit concurrently
+  Status status = Status::SUCCESS;
+  for (auto && bus : buses) {
+    size_t sent = bus->socket.writeBatch(bus->pending.data(), bus->pendingN);
+    if (sent < bus->pendingN) {
+      status = Status::FAIL;
+    }
+    bus->beginAwaiting();
+    for (size_t i = 0; i < sent; i++) {
+      bus->awaitReply(bus->pending[i].canId);
+    }
+    bus->pendingN = 0;
+    bus->deferred = false;
+  }
+  return status;
+}
+
+BusGroup::Status BusGroup::collect(std::chrono::microseconds timeout)
+{
+  auto deadline = CanFrame::Clock::now() + timeout;
+
+  while (true) {
+    pfds.clear();
+    for (auto && bus : buses) {
+      if (bus->awaitedReplies() == 0) {
+        continue;
+      }
+      if (bus->receive() > 0) {
+        bus->collectAnswers();
+      }
+      if (bus->awaitedReplies() > 0 and bus->socket.descriptor().has_value()) {
+        pfds.push_back({bus->socket.descriptor().value(), POLLIN, 0});
+      }
+    }
+
+    if (pfds.empty()) {
+      return std::all_of(buses.begin(), buses.end(), [](auto && bus) {
+               return bus->awaitedReplies() == 0;
+             })
+        ? Status::SUCCESS
+        : Status::FAIL;
+    }
+
+    auto remaining = deadline - CanFrame::Clock::now();
+    if (remaining <= CanFrame::Clock::duration::zero()) {
+      return Status::FAIL;
+    }
+
+    // a single wait over all the sockets, with sub-millisecond precision
+    auto sec = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+    struct timespec ts;
+    ts.tv_sec = sec.count();
+    ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - sec).count();
+    ppoll(pfds.data(), pfds.size(), &ts, nullptr);
+  }
+}
+
+BusGroup::Status BusGroup::cycle(std::chrono::microseconds timeout)
+{
+  Status sendStatus = send();
+  Status collectStatus = collect(timeout);
+  return sendStatus == Status::SUCCESS and collectStatus == Status::SUCCESS
+    ? Status::SUCCESS
+    : Status::FAIL;
+}
+
+/************************************ Bus ************************************/
+
+BusGroup::Bus::Bus(const std::string & canName)
+  : socket(canName)
+{ }
+
+BusGroup::Status BusGroup::Bus::write(const CanFrame & canFrame)
+{
+  return writeBatch(&canFrame, 1) == 1 ? Status::SUCCESS : Status::FAIL;
+}
+
+BusGroup::Status BusGroup::Bus::writeUrgent(const CanFrame & canFrame)
+{
+  // not deferred, it would wait for the whole cycle otherwise. The
+  // queued mode frames of the motor go out ahead of it.
+  auto end = std::remove_if(pending.begin(), pending.begin() + pendingN, [&](auto && command) {
+    if (command.canId != canFrame.canId) {
+      return false;
+    }
+    if (isModeFrame(command)) {
+      socket.writeUrgent(command);
+    }
+    return true;
+  });
+  pendingN = end - pending.begin();
+  Status status = socket.writeUrgent(canFrame);
+  if (status == Status::SUCCESS) {
+    countSent(&canFrame, 1);
+  } else {
+    countWriteFailures(&canFrame, 1);
+  }
+  return status;
+}
+
+std::optional<BusGroup::CanFrame> BusGroup::Bus::read()
+{
+  CanFrame canFrame;
+  if (readBatch(&canFrame, 1) == 1) {
+    return canFrame;
+  }
+  return {};
+}
+
+size_t BusGroup::Bus::writeBatch(const CanFrame * canFrames, size_t count)
+{
+  size_t queued = 0;
+  if (!deferred) {
+    queued = socket.writeBatch(canFrames, count);
+  } else {
+    queued = std::min(count, pending.size() - pendingN);
+    std::copy(canFrames, canFrames + queued, pending.begin() + pendingN);
+    pendingN += queued;
+  }
+  countSent(canFrames, queued);
+  countWriteFailures(canFrames + queued, count - queued);
+  return queued;
+}
+
+size_t BusGroup::Bus::readBatch(CanFrame * canFrames, size_t count)
+{
+  size_t received = socket.readBatch(canFrames, count);
+  countReceived(received);
+  return received;
+}
+
+bool BusGroup::Bus::wait(std::chrono::microseconds timeout)
+{
+  return socket.wait(timeout);
+}
+
+std::optional<int> BusGroup::Bus::descriptor() const noexcept
+{
+  return socket.descriptor();
+}
+
+void BusGroup::Bus::attachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::attachMotor(canId, masterCanId);
+  socket.attachMotor(canId, masterCanId);
+}
+
+void BusGroup::Bus::detachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::detachMotor(canId, masterCanId);
+  socket.detachMotor(canId, masterCanId);
+}
+
+void BusGroup::Bus::bitrate(uint32_t bitsPerSecond) noexcept
+{
+  socket.bitrate(bitsPerSecond);
+}
+
+kot_motor::transport::BusLoad BusGroup::Bus::busLoad() const noexcept
+{
+  return socket.busLoad();
+}
+
+std::chrono::nanoseconds BusGroup::Bus::frameTime() const noexcept
+{
+  return socket.frameTime();
+}
@@ -0,0 +1,80 @@
+#ifndef BUS_GROUP_HPP
+#define BUS_GROUP_HPP
+
+#include <poll.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "basic_transport.hpp"
+#include "socketcan_transport.hpp"
+
+namespace kot_motor::transport {
+
+// A set of CAN buses (e.g. one per leg) cycled together.
+// Motors are created on bus(i). Between beginCycle() and send() their
+// commands are queued instead of written, send() then passes every bus
+// its whole batch at once, so the frames go out on all the buses in
+// parallel, and collect() waits on all the sockets at once until every
+// command got its reply or the timeout expires.
+class BusGroup {
+public:
+  using Status = BasicTransport::Status;
+  using CanFrame = BasicTransport::CanFrame;
+
+public:
+  BusGroup(const std::vector<std::string> & canNames);
+  BusGroup(const BusGroup &) = delete;
+  BusGroup & operator=(const BusGroup &) = delete;
+  ~BusGroup();
+
+  Status open();
+  Status close();
+
+  size_t size() const noexcept;
+  BasicTransport & bus(size_t i);
+  SocketCanTransport & socket(size_t i);
+
+  // Cycle
+  void beginCycle() noexcept;
+  Status send();
+  Status collect(std::chrono::microseconds timeout);
+  Status cycle(std::chrono::microseconds timeout);
+
+private:
+  class Bus : public BasicTransport {
+  public:
+    Bus(const std::string & canName);
+
+    Status write(const CanFrame & canFrame) override;
+    Status writeUrgent(const CanFrame & canFrame) override;
+    std::optional<CanFrame> read() override;
+    size_t writeBatch(const CanFrame * canFrames, size_t count) override;
+    size_t readBatch(CanFrame * canFrames, size_t count) override;
+    bool wait(std::chrono::microseconds timeout) override;
+    std::optional<int> descriptor() const noexcept override;
+
+    void attachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+    void detachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+
+    void bitrate(uint32_t bitsPerSecond) noexcept override;
+    BusLoad busLoad() const noexcept override;
+    std::chrono::nanoseconds frameTime() const noexcept override;
+
+    SocketCanTransport socket;
+    bool deferred = false;
+    std::array<CanFrame, SocketCanTransport::BATCH_SIZE> pending;
+    size_t pendingN = 0;
+    using BasicTransport::beginAwaiting; // the replies are awaited by the group
+    using BasicTransport::awaitReply;
+    using BasicTransport::collectAnswers;
+    using BasicTransport::awaitedReplies;
+  };
+
+private:
+  std::vector<std::unique_ptr<Bus>> buses;
+  std::vector<struct pollfd> pfds; // reserved once, no allocation per cycle
+};
+
+} // namespace kot_motor::transport
+
+#endif // BUS_GROUP_HPP
@@ -0,0 +1,69 @@
+#include "bus_load.hpp"
+
+using kot_motor::transport::BusLoad;
+
+static_assert(BusLoad::frameBits(BusLoad::COMMAND_SIZE) == 135);
+static_assert(BusLoad::frameBits(BusLoad::REPLY_SIZE) == 115);
+
+BusLoad::BusLoad(uint32_t bitrate) noexcept
+  : bitsPerSecond(bitrate > 0 ? bitrate : DEFAULT_BITRATE)
+{ }
+
+uint32_t BusLoad::bitrate() const noexcept
+{
+  return bitsPerSecond;
+}
+
+std::chrono::nanoseconds BusLoad::frameTime(uint8_t size) const noexcept
+{
+  // rounded up, a frame never takes less than its bits
+  uint64_t bits = frameBits(size);
+  return std::chrono::nanoseconds((bits * 1000000000 + bitsPerSecond - 1) / bitsPerSecond);
+}
+
+std::chrono::nanoseconds BusLoad::commandTime() const noexcept
+{
+  return frameTime(COMMAND_SIZE);
+}
+
+std::chrono::nanoseconds BusLoad::replyTime() const noexcept
+{
+  return frameTime(REPLY_SIZE);
+}
+
+std::chrono::nanoseconds BusLoad::exchangeTime() const noexcept
+{
+  return commandTime() + replyTime();
+}
+
+double BusLoad::utilization(
+  const TransportStats::Counters & from,
+  const TransportStats::Counters & to,
+  std::chrono::nanoseconds elapsed
+) const noexcept
+{
+  if (elapsed.count() <= 0) {
+    return 0.0;
+  }
+
+  double bits = double(to.sent - from.sent) * frameBits(COMMAND_SIZE) +
+                double(to.received - from.received) * frameBits(REPLY_SIZE);
+  return bits / (double(bitsPerSecond) * std::chrono::duration<double>(elapsed).count());
+}
+
+BusLoad::Schedule BusLoad::schedule(size_t motors, double loopRate) const noexcept
+{
+  Schedule schedule;
+  schedule.period = std::chrono::nanoseconds(loopRate > 0.0 ? int64_t(1e9 / loopRate) : 0);
+  if (schedule.period.count() <= 0) {
+    return schedule;
+  }
+
+  schedule.busy = exchangeTime() * motors;
+  schedule.load = double(schedule.busy.count()) / double(schedule.period.count());
+  schedule.maxMotors = size_t(
+    MAX_SCHEDULED_LOAD * double(schedule.period.count()) / double(exchangeTime().count())
+  );
+  schedule.fits = schedule.load <= MAX_SCHEDULED_LOAD;
+  return schedule;
+}
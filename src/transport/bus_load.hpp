@@ -0,0 +1,68 @@
+#ifndef BUS_LOAD_HPP
+#define BUS_LOAD_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include "transport_stats.hpp"
+
+namespace kot_motor::transport {
+
+// Time the frames take on the wire at the bitrate of the bus. A classic
+// frame with an 11 bit id has 47 bits of framing (the interframe space
+// included), 34 of them plus the data may get a stuff bit after every
+// 4 bits in the worst case (Davis et al., "Controller Area Network (CAN)
+// schedulability analysis: refuted, revisited and revised").
+class BusLoad {
+public:
+  static constexpr uint32_t DEFAULT_BITRATE = 1000000;
+  // the command of the motors and their reply
+  static constexpr uint8_t COMMAND_SIZE = 8;
+  static constexpr uint8_t REPLY_SIZE = 6;
+  // the most of the bus a schedule may take, the rest is left to the
+  // arbitration delays and the retransmissions
+  static constexpr double MAX_SCHEDULED_LOAD = 0.8;
+
+  struct Schedule {
+    std::chrono::nanoseconds period{0}; // of the loop
+    std::chrono::nanoseconds busy{0};   // taken by the commands and the replies of a cycle
+    double load = 0.0;                  // busy / period
+    size_t maxMotors = 0;               // the most motors fitting at this rate
+    bool fits = false;                  // load within MAX_SCHEDULED_LOAD
+  };
+
+public:
+  explicit BusLoad(uint32_t bitrate = DEFAULT_BITRATE) noexcept;
+
+  // Worst case bits of a frame with `size` data bytes
+  static constexpr unsigned frameBits(uint8_t size) noexcept
+  {
+    return 47 + 8 * size + (34 + 8 * size - 1) / 4;
+  }
+
+  uint32_t bitrate() const noexcept;
+  std::chrono::nanoseconds frameTime(uint8_t size) const noexcept;
+  std::chrono::nanoseconds commandTime() const noexcept;
+  std::chrono::nanoseconds replyTime() const noexcept;
+  // a command and its reply, the bus time of one motor update
+  std::chrono::nanoseconds exchangeTime() const noexcept;
+
+  // Share of the bus used between two snapshots of the counters taken
+  // `elapsed` apart, the sent frames are taken for commands and the
+  // received ones for replies
+  double utilization(
+    const TransportStats::Counters & from,
+    const TransportStats::Counters & to,
+    std::chrono::nanoseconds elapsed
+  ) const noexcept;
+
+  // Whether updating `motors` motors at `loopRate` Hz leaves the bus headroom
+  Schedule schedule(size_t motors, double loopRate) const noexcept;
+
+private:
+  uint32_t bitsPerSecond;
+};
+
+} // namespace kot_motor::transport
+
+#endif // BUS_LOAD_HPP
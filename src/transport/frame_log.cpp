@@ -0,0 +1,29 @@
+#include <algorithm>
+#include <cstring>
+#include "frame_log.hpp"
+
+namespace kot_motor::transport::frame_log {
+
+Record toRecord(const BasicTransport::CanFrame & canFrame, Direction direction) noexcept
+{
+  Record record = {};
+  record.timestampNs =
+    std::chrono::duration_cast<std::chrono::nanoseconds>(canFrame.timestamp.time_since_epoch()).count();
+  record.canId = canFrame.canId;
+  record.size = std::min<uint8_t>(canFrame.size, sizeof(record.data));
+  record.direction = direction;
+  std::memcpy(record.data, canFrame.data, record.size);
+  return record;
+}
+
+BasicTransport::CanFrame fromRecord(const Record & record) noexcept
+{
+  uint8_t size = std::min<uint8_t>(record.size, sizeof(record.data));
+  BasicTransport::CanFrame canFrame{record.canId, record.data, size};
+  canFrame.timestamp = BasicTransport::CanFrame::Clock::time_point(
+    std::chrono::duration_cast<BasicTransport::CanFrame::Clock::duration>(std::chrono::nanoseconds(record.timestampNs))
+  );
+  return canFrame;
+}
+
+} // namespace kot_motor::transport::frame_log
@@ -0,0 +1,44 @@
+#ifndef FRAME_LOG_HPP
+#define FRAME_LOG_HPP
+
+#include <stdint.h>
+#include "basic_transport.hpp"
+
+namespace kot_motor::transport::frame_log {
+
+// Binary frame log: a header followed by fixed size records, all in the
+// host byte order. The ids are stored as they were on the wire, so a
+// reply is logged with the master id it was sent to.
+
+constexpr char MAGIC[8] = {'K', 'O', 'T', 'C', 'A', 'N', 'L', 'G'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+};
+
+enum class Direction : uint8_t {
+  SENT,
+  RECEIVED
+};
+
+struct Record {
+  int64_t timestampNs; // steady clock
+  uint32_t canId;
+  uint8_t size;
+  Direction direction;
+  uint8_t reserved[2];
+  uint8_t data[8];
+};
+
+static_assert(sizeof(Header) == 16, "the header layout is a part of the file format");
+static_assert(sizeof(Record) == 24, "the record layout is a part of the file format");
+
+Record toRecord(const BasicTransport::CanFrame & canFrame, Direction direction) noexcept;
+BasicTransport::CanFrame fromRecord(const Record & record) noexcept;
+
+} // namespace kot_motor::transport::frame_log
+
+#endif // FRAME_LOG_HPP
@@ -0,0 +1,363 @@
+#include <array>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include "io_engine.hpp"
+
+using kot_motor::transport::IoEngine;
+using kot_motor::transport::BusLoad;
+
+IoEngine::IoEngine(BasicTransport & bus)
+  : IoEngine(bus, Options{})
+{ }
+
+namespace {
+
+void toTimespec(std::chrono::nanoseconds timeout, struct timespec & ts)
+{
+  auto sec = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  ts.tv_sec = sec.count();
+  ts.tv_nsec = (timeout - sec).count();
+}
+
+void drain(int fd)
+{
+  uint64_t count;
+  while (::read(fd, &count, sizeof(count)) == -1 and errno == EINTR) { }
+}
+
+} // namespace
+
+IoEngine::IoEngine(BasicTransport & bus, const Options & options)
+  : bus(bus)
+  , options(options)
+  , commandsReady(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+  , feedbackReady(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+{ }
+
+IoEngine::~IoEngine()
+{
+  stop();
+  if (commandsReady != -1) {
+    ::close(commandsReady);
+  }
+  if (feedbackReady != -1) {
+    ::close(feedbackReady);
+  }
+}
+
+IoEngine::Status IoEngine::start()
+{
+  if (running.load()) {
+    return Status::FAIL;
+  }
+
+  bool locked = true;
+  if (options.lockMemory) {
+    // no page faults on the bus thread once it's running
+    locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+  }
+
+  realtime = locked;
+  running = true;
+  worker = std::thread(&IoEngine::run, this);
+
+  return Status::SUCCESS_INIT;
+}
+
+IoEngine::Status IoEngine::stop()
+{
+  if (!running.exchange(false)) {
+    return Status::FAIL;
+  }
+  wake(commandsReady, busSleeping);
+  worker.join();
+  return Status::SUCCESS;
+}
+
+bool IoEngine::isRunning() const noexcept
+{
+  return running.load();
+}
+
+bool IoEngine::isRealtime() const noexcept
+{
+  return realtime.load();
+}
+
+uint64_t IoEngine::droppedFeedback() const noexcept
+{
+  return dropped.load(std::memory_order_relaxed);
+}
+
+/***************************** Application side *****************************/
+
+IoEngine::Status IoEngine::write(const CanFrame & canFrame)
+{
+  if (!commands.push({canFrame, queued++})) {
+    countWriteFailures(&canFrame, 1);
+    return Status::FAIL;
+  }
+  wake(commandsReady, busSleeping);
+  countSent(&canFrame, 1);
+  return Status::SUCCESS;
+}
+
+IoEngine::Status IoEngine::writeUrgent(const CanFrame & canFrame)
+{
+  if (!urgent.push({canFrame, queued++})) {
+    countWriteFailures(&canFrame, 1);
+    return Status::FAIL;
+  }
+  wake(commandsReady, busSleeping);
+  countSent(&canFrame, 1);
+  return Status::SUCCESS;
+}
+
+std::optional<IoEngine::CanFrame> IoEngine::read()
+{
+  auto canFrame = feedback.pop();
+  if (canFrame.has_value()) {
+    countReceived(1);
+  }
+  return canFrame;
+}
+
+size_t IoEngine::writeBatch(const CanFrame * canFrames, size_t count)
+{
+  size_t queued = 0;
+  size_t pushed = 0;
+  while (pushed < count and commands.push({canFrames[pushed], queued++})) {
+    pushed++;
+  }
+  if (pushed > 0) {
+    wake(commandsReady, busSleeping);
+  }
+  countSent(canFrames, pushed);
+  countWriteFailures(canFrames + pushed, count - pushed);
+  return pushed;
+}
+
+bool IoEngine::wait(std::chrono::microseconds timeout)
+{
+  auto deadline = CanFrame::Clock::now() + timeout;
+  while (true) {
+    // the flag is raised before the ring is checked, the bus thread
+    // pushes before it checks the flag, so a push is never missed
+    applicationWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool ready = feedback.size() > 0;
+    auto remaining = deadline - CanFrame::Clock::now();
+    if (ready or remaining <= CanFrame::Clock::duration::zero()) {
+      applicationWaiting.store(false, std::memory_order_relaxed);
+      return ready;
+    }
+
+    if (feedbackReady == -1) {
+      std::this_thread::yield();
+      continue;
+    }
+    struct pollfd pfd = {feedbackReady, POLLIN, 0};
+    struct timespec ts;
+    toTimespec(remaining, ts);
+    if (ppoll(&pfd, 1, &ts, nullptr) > 0) {
+      drain(feedbackReady);
+    }
+  }
+}
+
+IoEngine::CanFrame::Clock::time_point IoEngine::now() const noexcept
+{
+  return bus.now();
+}
+
+void IoEngine::attachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::attachMotor(canId, masterCanId);
+  bus.attachMotor(canId, masterCanId);
+}
+
+void IoEngine::detachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::detachMotor(canId, masterCanId);
+  bus.detachMotor(canId, masterCanId);
+}
+
+void IoEngine::bitrate(uint32_t bitsPerSecond) noexcept
+{
+  bus.bitrate(bitsPerSecond);
+}
+
+BusLoad IoEngine::busLoad() const noexcept
+{
+  return bus.busLoad();
+}
+
+std::chrono::nanoseconds IoEngine::frameTime() const noexcept
+{
+  return bus.frameTime();
+}
+
+/******************************** Bus thread ********************************/
+
+void IoEngine::run()
+{
+  if (!configureThread()) {
+    realtime = false;
+  }
+
+  std::array<CanFrame, BATCH_SIZE> pending; // commands the bus hasn't taken yet
+  std::array<uint64_t, BATCH_SIZE> pendingSequences;
+  std::array<CanFrame, BATCH_SIZE> received;
+  size_t pendingN = 0;
+  std::optional<Queued> command; // popped, queued after an urgent frame or out of a full batch
+  std::optional<Queued> frame;   // urgent, behind commands out of a full batch
+
+  auto nextCommand = [&]() {
+    if (!command.has_value()) {
+      command = commands.pop();
+    }
+    return command.has_value();
+  };
+  // takes the commands queued before `sequence` while the batch has room
+  auto take = [&](uint64_t sequence) {
+    while (pendingN < pending.size() and nextCommand() and command->sequence < sequence) {
+      pending[pendingN] = command->canFrame;
+      pendingSequences[pendingN++] = command->sequence;
+      command.reset();
+    }
+  };
+  auto flush = [&]() {
+    size_t sent = bus.writeBatch(pending.data(), pendingN);
+    std::copy(pending.begin() + sent, pending.begin() + pendingN, pending.begin());
+    std::copy(pendingSequences.begin() + sent, pendingSequences.begin() + pendingN, pendingSequences.begin());
+    pendingN -= sent;
+    return sent;
+  };
+
+  while (running.load(std::memory_order_relaxed)) {
+    // the frames go out in the order they were queued, but the urgent
+    // ones overtake the commands not passed to the bus yet and supersede
+    // the earlier ones of their motor, except its mode frames, which go
+    // out ahead of them
+    while (true) {
+      if (!frame.has_value() and !(frame = urgent.pop()).has_value()) {
+        take(UINT64_MAX);
+        // an urgent frame queued before some of the commands just taken
+        if (!(frame = urgent.pop()).has_value()) {
+          break;
+        }
+      }
+
+      take(frame->sequence);
+      if (pendingN == pending.size() and nextCommand() and command->sequence < frame->sequence) {
+        // commands queued before it are out of a full batch, the bus takes some first
+        if (flush() == 0) {
+          break;
+        }
+        continue;
+      }
+
+      size_t kept = 0;
+      for (size_t i = 0; i < pendingN; i++) {
+        if (pending[i].canId != frame->canFrame.canId or pendingSequences[i] > frame->sequence) {
+          pending[kept] = pending[i];
+          pendingSequences[kept++] = pendingSequences[i];
+        } else if (isModeFrame(pending[i])) {
+          bus.writeUrgent(pending[i]);
+        }
+      }
+      pendingN = kept;
+      bus.writeUrgent(frame->canFrame);
+      frame.reset();
+    }
+
+    if (pendingN > 0) {
+      flush();
+    }
+
+    if (!waitBus()) {
+      continue;
+    }
+
+    size_t receivedN = bus.readBatch(received.data(), received.size());
+    for (size_t i = 0; i < receivedN; i++) {
+      if (!feedback.push(received[i])) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    if (receivedN > 0) {
+      wake(feedbackReady, applicationWaiting);
+    }
+  }
+}
+
+bool IoEngine::waitBus() noexcept
+{
+  auto busFd = bus.descriptor();
+  if (!busFd.has_value() or commandsReady == -1) {
+    return bus.wait(options.idleWait);
+  }
+
+  // flushes what the bus holds, a frame already there needs no sleep
+  if (bus.wait(std::chrono::microseconds(0))) {
+    return true;
+  }
+
+  // the flag is raised before the rings are checked, the application
+  // pushes before it checks the flag, so a push is never missed
+  busSleeping.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  bool readable = false;
+  if (commands.size() == 0 and urgent.size() == 0 and running.load(std::memory_order_relaxed)) {
+    struct pollfd pfds[2] = {{busFd.value(), POLLIN, 0}, {commandsReady, POLLIN, 0}};
+    struct timespec ts;
+    toTimespec(options.idleWait, ts);
+    if (ppoll(pfds, 2, &ts, nullptr) > 0) {
+      readable = pfds[0].revents & POLLIN;
+      if (pfds[1].revents & POLLIN) {
+        drain(commandsReady);
+      }
+    }
+  }
+  busSleeping.store(false, std::memory_order_relaxed);
+  return readable;
+}
+
+void IoEngine::wake(int fd, const std::atomic<bool> & sleeping) noexcept
+{
+  // the push is ordered before the check of the flag, the other side
+  // raises the flag before it checks the ring
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (fd == -1 or !sleeping.load(std::memory_order_relaxed)) {
+    return;
+  }
+  uint64_t one = 1;
+  while (::write(fd, &one, sizeof(one)) == -1 and errno == EINTR) { }
+}
+
+bool IoEngine::configureThread() noexcept
+{
+  bool ok = true;
+
+  if (options.cpu.has_value()) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(options.cpu.value(), &cpus);
+    ok &= pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+  }
+
+  if (options.priority.has_value()) {
+    struct sched_param param = {};
+    param.sched_priority = options.priority.value();
+    ok &= pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+  }
+
+  return ok;
+}
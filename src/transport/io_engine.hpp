@@ -0,0 +1,101 @@
+#ifndef IO_ENGINE_HPP
+#define IO_ENGINE_HPP
+
+#include <atomic>
+#include <thread>
+#include "basic_transport.hpp"
+#include "spsc_ring.hpp"
+
+namespace kot_motor::transport {
+
+// Owns a transport and drives it from a dedicated real-time thread.
+// The engine itself is a transport for the application: write() queues
+// a command and read() takes a feedback frame, both through wait-free
+// rings, so the caller never touches the bus. Commands have to come from
+// one thread and feedback has to be consumed by one thread, which may be
+// the same. Motors should be attached before start().
+// Neither side spins: the bus thread sleeps on the bus and an eventfd the
+// application signals when it pushes to a sleeping thread, the
+// application's wait() sleeps on an eventfd the bus thread signals when
+// it pushes feedback to a waiting application. A bus without a
+// descriptor is waited on by its wait() for at most the idle wait.
+class IoEngine : public BasicTransport {
+public:
+  static constexpr size_t RING_SIZE = 256;
+  static constexpr size_t URGENT_RING_SIZE = 16;
+  static constexpr size_t BATCH_SIZE = 64;
+  static constexpr std::chrono::microseconds DEFAULT_IDLE_WAIT{100};
+
+  struct Options {
+    std::optional<int> cpu;                              // core the bus thread is pinned to
+    std::optional<int> priority;                         // SCHED_FIFO priority, none keeps the default policy
+    bool lockMemory = false;                             // mlockall the whole process
+    std::chrono::microseconds idleWait = DEFAULT_IDLE_WAIT; // max sleep of the bus thread with nothing to do
+  };
+
+public:
+  IoEngine(BasicTransport & bus);
+  IoEngine(BasicTransport & bus, const Options & options);
+  IoEngine(const IoEngine &) = delete;
+  IoEngine & operator=(const IoEngine &) = delete;
+  ~IoEngine();
+
+  Status start();
+  Status stop();
+  bool isRunning() const noexcept;
+  // false if pinning, SCHED_FIFO or mlockall were refused by the system
+  bool isRealtime() const noexcept;
+  // feedback frames lost because the application didn't take them
+  uint64_t droppedFeedback() const noexcept;
+
+  // Application side
+  Status write(const CanFrame & canFrame) override;
+  Status writeUrgent(const CanFrame & canFrame) override;
+  std::optional<CanFrame> read() override;
+  size_t writeBatch(const CanFrame * canFrames, size_t count) override;
+  bool wait(std::chrono::microseconds timeout) override;
+  CanFrame::Clock::time_point now() const noexcept override;
+
+  void attachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+  void detachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+
+  void bitrate(uint32_t bitsPerSecond) noexcept override;
+  BusLoad busLoad() const noexcept override;
+  std::chrono::nanoseconds frameTime() const noexcept override;
+
+private:
+  void run();
+  bool configureThread() noexcept;
+  bool waitBus() noexcept;
+  void wake(int fd, const std::atomic<bool> & sleeping) noexcept;
+
+private:
+  BasicTransport & bus;
+  Options options;
+
+  std::thread worker;
+  std::atomic<bool> running{false};
+  std::atomic<bool> realtime{false};
+  std::atomic<uint64_t> dropped{0};
+
+  // a frame with its place among all the frames the application queued
+  struct Queued {
+    CanFrame canFrame;
+    uint64_t sequence;
+  };
+
+  SpscRing<Queued, RING_SIZE> commands;      // application -> bus thread
+  SpscRing<Queued, URGENT_RING_SIZE> urgent; // application -> bus thread, ahead of the later commands
+  SpscRing<CanFrame, RING_SIZE> feedback; // bus thread -> application
+  uint64_t queued = 0; // application side, the sequence of the next frame
+
+  // eventfds, -1 if none could be created and the sides poll instead
+  int commandsReady = -1;
+  int feedbackReady = -1;
+  std::atomic<bool> busSleeping{false};
+  std::atomic<bool> applicationWaiting{false};
+};
+
+} // namespace kot_motor::transport
+
+#endif // IO_ENGINE_HPP
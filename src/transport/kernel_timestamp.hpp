@@ -0,0 +1,64 @@
+#ifndef KERNEL_TIMESTAMP_HPP
+#define KERNEL_TIMESTAMP_HPP
+
+#include <chrono>
+#include <time.h>
+#include <sys/socket.h>
+#include <linux/net_tstamp.h>
+#include "basic_transport.hpp"
+
+namespace kot_motor::transport::kernel_timestamp {
+
+using CanFrame = BasicTransport::CanFrame;
+
+// enough for SCM_TIMESTAMPING, which carries three timespecs
+struct ControlBuffer {
+  alignas(struct cmsghdr) char data[CMSG_SPACE(3 * sizeof(struct timespec))];
+};
+
+struct ClockOffset {
+  CanFrame::Clock::time_point steadyNow;
+  std::chrono::nanoseconds realtimeNow;
+};
+
+inline std::chrono::nanoseconds toDuration(const struct timespec & ts)
+{
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+// the kernel stamps with CLOCK_REALTIME, the frames carry the steady clock
+inline ClockOffset clockOffset()
+{
+  struct timespec realtime;
+  clock_gettime(CLOCK_REALTIME, &realtime);
+  return {CanFrame::Clock::now(), toDuration(realtime)};
+}
+
+// Timestamp of the reception by the kernel converted to the steady clock,
+// falls back to the time of reading when the socket delivered none
+inline CanFrame::Clock::time_point fromControl(const struct msghdr & msg, const ClockOffset & offset)
+{
+  const struct timespec * ts = nullptr;
+  for (struct cmsghdr * cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(const_cast<struct msghdr *>(&msg), cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET) {
+      continue;
+    }
+    if (cmsg->cmsg_type == SCM_TIMESTAMPING or cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      // the software stamp is the first one of SCM_TIMESTAMPING
+      ts = reinterpret_cast<const struct timespec *>(CMSG_DATA(cmsg));
+      break;
+    }
+  }
+
+  if (ts == nullptr or (ts->tv_sec == 0 and ts->tv_nsec == 0)) {
+    return offset.steadyNow;
+  }
+
+  auto age = offset.realtimeNow - toDuration(*ts);
+  return offset.steadyNow - std::chrono::duration_cast<CanFrame::Clock::duration>(age);
+}
+
+} // namespace kot_motor::transport::kernel_timestamp
+
+#endif // KERNEL_TIMESTAMP_HPP
@@ -0,0 +1,204 @@
+#include <array>
+#include "recording_transport.hpp"
+
+using kot_motor::transport::RecordingTransport;
+using kot_motor::transport::BusLoad;
+using namespace kot_motor::transport::frame_log;
+
+RecordingTransport::RecordingTransport(BasicTransport & bus, const std::string & path)
+  : bus(bus)
+  , path(path)
+{ }
+
+RecordingTransport::~RecordingTransport()
+{
+  close();
+}
+
+RecordingTransport::Status RecordingTransport::open()
+{
+  if (file != nullptr) {
+    return Status::FAIL;
+  }
+
+  file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return Status::FAIL;
+  }
+
+  Header header = {};
+  std::copy(std::begin(MAGIC), std::end(MAGIC), header.magic);
+  header.version = VERSION;
+  header.recordSize = sizeof(Record);
+  if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+    std::fclose(file);
+    file = nullptr;
+    return Status::FAIL;
+  }
+
+  running = true;
+  writer = std::thread(&RecordingTransport::writeLoop, this);
+  return Status::SUCCESS_INIT;
+}
+
+RecordingTransport::Status RecordingTransport::close()
+{
+  if (file == nullptr) {
+    return Status::FAIL;
+  }
+
+  running = false;
+  writer.join(); // the writer drains the ring before leaving
+
+  bool flushed = std::fclose(file) == 0;
+  file = nullptr;
+  return flushed ? Status::SUCCESS : Status::FAIL;
+}
+
+uint64_t RecordingTransport::droppedRecords() const noexcept
+{
+  return dropped.load(std::memory_order_relaxed);
+}
+
+/******************************** Transport ********************************/
+
+RecordingTransport::Status RecordingTransport::write(const CanFrame & canFrame)
+{
+  Status status = bus.write(canFrame);
+  if (status == Status::SUCCESS) {
+    recordSent(&canFrame, 1);
+  } else {
+    countWriteFailures(&canFrame, 1);
+  }
+  return status;
+}
+
+RecordingTransport::Status RecordingTransport::writeUrgent(const CanFrame & canFrame)
+{
+  Status status = bus.writeUrgent(canFrame);
+  if (status == Status::SUCCESS) {
+    recordSent(&canFrame, 1);
+  } else {
+    countWriteFailures(&canFrame, 1);
+  }
+  return status;
+}
+
+std::optional<RecordingTransport::CanFrame> RecordingTransport::read()
+{
+  auto canFrame = bus.read();
+  if (canFrame.has_value()) {
+    record(canFrame.value(), Direction::RECEIVED);
+    countReceived(1);
+  }
+  return canFrame;
+}
+
+size_t RecordingTransport::writeBatch(const CanFrame * canFrames, size_t count)
+{
+  size_t sent = bus.writeBatch(canFrames, count);
+  recordSent(canFrames, sent);
+  countWriteFailures(canFrames + sent, count - sent);
+  return sent;
+}
+
+size_t RecordingTransport::readBatch(CanFrame * canFrames, size_t count)
+{
+  size_t received = bus.readBatch(canFrames, count);
+  for (size_t i = 0; i < received; i++) {
+    record(canFrames[i], Direction::RECEIVED);
+  }
+  countReceived(received);
+  return received;
+}
+
+bool RecordingTransport::wait(std::chrono::microseconds timeout)
+{
+  return bus.wait(timeout);
+}
+
+std::optional<int> RecordingTransport::descriptor() const noexcept
+{
+  return bus.descriptor();
+}
+
+RecordingTransport::CanFrame::Clock::time_point RecordingTransport::now() const noexcept
+{
+  return bus.now();
+}
+
+void RecordingTransport::attachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::attachMotor(canId, masterCanId);
+  bus.attachMotor(canId, masterCanId);
+}
+
+void RecordingTransport::detachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::detachMotor(canId, masterCanId);
+  bus.detachMotor(canId, masterCanId);
+}
+
+void RecordingTransport::bitrate(uint32_t bitsPerSecond) noexcept
+{
+  bus.bitrate(bitsPerSecond);
+}
+
+BusLoad RecordingTransport::busLoad() const noexcept
+{
+  return bus.busLoad();
+}
+
+std::chrono::nanoseconds RecordingTransport::frameTime() const noexcept
+{
+  return bus.frameTime();
+}
+
+/********************************* Logging *********************************/
+
+void RecordingTransport::record(const CanFrame & canFrame, Direction direction) noexcept
+{
+  if (file == nullptr) {
+    return;
+  }
+  if (!records.push(toRecord(canFrame, direction))) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void RecordingTransport::recordSent(const CanFrame * canFrames, size_t count) noexcept
+{
+  // the commands carry no time, they are stamped when handed to the bus
+  auto now = CanFrame::Clock::now();
+  for (size_t i = 0; i < count; i++) {
+    CanFrame canFrame = canFrames[i];
+    canFrame.timestamp = now;
+    record(canFrame, Direction::SENT);
+  }
+  countSent(canFrames, count, now);
+}
+
+void RecordingTransport::writeLoop()
+{
+  std::array<Record, 256> chunk;
+  while (true) {
+    bool stopping = !running.load();
+
+    size_t chunkN = 0;
+    while (chunkN < chunk.size()) {
+      auto record = records.pop();
+      if (!record.has_value()) {
+        break;
+      }
+      chunk[chunkN++] = record.value();
+    }
+
+    if (chunkN > 0) {
+      std::fwrite(chunk.data(), sizeof(Record), chunkN, file);
+    } else if (stopping) {
+      break;
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
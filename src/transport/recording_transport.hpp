@@ -0,0 +1,67 @@
+#ifndef RECORDING_TRANSPORT_HPP
+#define RECORDING_TRANSPORT_HPP
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include "basic_transport.hpp"
+#include "frame_log.hpp"
+#include "spsc_ring.hpp"
+
+namespace kot_motor::transport {
+
+// Wraps any transport and logs every frame sent and received through it
+// into a binary frame log. The caller only pushes records into a
+// wait-free ring, a background thread writes them to the file. All the
+// calls have to come from one thread, as with IoEngine.
+class RecordingTransport : public BasicTransport {
+public:
+  static constexpr size_t RING_SIZE = 4096;
+
+public:
+  RecordingTransport(BasicTransport & bus, const std::string & path);
+  RecordingTransport(const RecordingTransport &) = delete;
+  RecordingTransport & operator=(const RecordingTransport &) = delete;
+  ~RecordingTransport();
+
+  Status open();
+  Status close();
+  // records lost because the writer couldn't keep up
+  uint64_t droppedRecords() const noexcept;
+
+  Status write(const CanFrame & canFrame) override;
+  Status writeUrgent(const CanFrame & canFrame) override;
+  std::optional<CanFrame> read() override;
+  size_t writeBatch(const CanFrame * canFrames, size_t count) override;
+  size_t readBatch(CanFrame * canFrames, size_t count) override;
+  bool wait(std::chrono::microseconds timeout) override;
+  std::optional<int> descriptor() const noexcept override;
+  CanFrame::Clock::time_point now() const noexcept override;
+
+  void attachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+  void detachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+
+  void bitrate(uint32_t bitsPerSecond) noexcept override;
+  BusLoad busLoad() const noexcept override;
+  std::chrono::nanoseconds frameTime() const noexcept override;
+
+private:
+  void record(const CanFrame & canFrame, frame_log::Direction direction) noexcept;
+  void recordSent(const CanFrame * canFrames, size_t count) noexcept;
+  void writeLoop();
+
+private:
+  BasicTransport & bus;
+  const std::string path;
+
+  std::FILE * file = nullptr;
+  std::thread writer;
+  std::atomic<bool> running{false};
+  std::atomic<uint64_t> dropped{0};
+  SpscRing<frame_log::Record, RING_SIZE> records;
+};
+
+} // namespace kot_motor::transport
+
+#endif // RECORDING_TRANSPORT_HPP
@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "replay_transport.hpp"
+
+using kot_motor::transport::ReplayTransport;
+using namespace kot_motor::transport::frame_log;
+
+ReplayTransport::ReplayTransport(const std::string & path, float speed)
+  : path(path)
+  , speed(speed)
+{ }
+
+ReplayTransport::~ReplayTransport()
+{
+  close();
+}
+
+ReplayTransport::Status ReplayTransport::open()
+{
+  if (mapping != nullptr) {
+    return Status::FAIL;
+  }
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return Status::FAIL;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 or size_t(st.st_size) < sizeof(Header)) {
+    ::close(fd);
+    return Status::FAIL;
+  }
+
+  // the mapping stays valid after the descriptor is closed
+  void * map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED) {
+    return Status::FAIL;
+  }
+
+  const Header * header = static_cast<const Header *>(map);
+  if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 or
+      header->version != VERSION or header->recordSize != sizeof(Record)) {
+    munmap(map, st.st_size);
+    return Status::FAIL;
+  }
+
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  mapping = map;
+  mappingSize = st.st_size;
+  records = reinterpret_cast<const Record *>(static_cast<const char *>(map) + sizeof(Header));
+  recordsN = (mappingSize - sizeof(Header)) / sizeof(Record);
+
+  restart();
+  return Status::SUCCESS_INIT;
+}
+
+ReplayTransport::Status ReplayTransport::close()
+{
+  if (mapping == nullptr) {
+    return Status::FAIL;
+  }
+  munmap(mapping, mappingSize);
+  mapping = nullptr;
+  records = nullptr;
+  recordsN = 0;
+  next = 0;
+  return Status::SUCCESS;
+}
+
+/****************************** Replay control ******************************/
+
+void ReplayTransport::restart() noexcept
+{
+  next = 0;
+  started = CanFrame::Clock::now();
+  nextReceived();
+}
+
+bool ReplayTransport::finished() const noexcept
+{
+  return next >= recordsN;
+}
+
+size_t ReplayTransport::recordsCount() const noexcept
+{
+  return recordsN;
+}
+
+bool ReplayTransport::nextReceived() noexcept
+{
+  while (next < recordsN and records[next].direction != Direction::RECEIVED) {
+    next++;
+  }
+  return next < recordsN;
+}
+
+ReplayTransport::CanFrame::Clock::time_point ReplayTransport::due(const Record & record) const noexcept
+{
+  if (speed <= AS_FAST_AS_POSSIBLE) {
+    return started;
+  }
+  auto sinceFirst = std::chrono::nanoseconds(record.timestampNs - records[0].timestampNs);
+  auto scaled = std::chrono::duration<double, std::nano>(sinceFirst) / double(speed);
+  return started + std::chrono::duration_cast<CanFrame::Clock::duration>(scaled);
+}
+
+/******************************** Transport ********************************/
+
+ReplayTransport::Status ReplayTransport::write(const CanFrame & canFrame)
+{
+  if (mapping == nullptr) {
+    return Status::FAIL;
+  }
+  countSent(&canFrame, 1);
+  return Status::SUCCESS;
+}
+
+std::optional<ReplayTransport::CanFrame> ReplayTransport::read()
+{
+  if (!nextReceived()) {
+    return {};
+  }
+
+  auto dueTime = due(records[next]);
+  if (dueTime > CanFrame::Clock::now()) {
+    return {};
+  }
+
+  // stamped on the replay time line, so the ages stay meaningful. All
+  // at once, the frames are due at the start and stamped at delivery
+  // instead, a reply then answers the command written before it.
+  CanFrame canFrame = fromRecord(records[next++]);
+  canFrame.timestamp = speed <= AS_FAST_AS_POSSIBLE ? CanFrame::Clock::now() : dueTime;
+  countReceived(1);
+  return canFrame;
+}
+
+bool ReplayTransport::wait(std::chrono::microseconds timeout)
+{
+  auto deadline = CanFrame::Clock::now() + timeout;
+  if (!nextReceived()) {
+    std::this_thread::sleep_until(deadline);
+    return false;
+  }
+
+  auto dueTime = due(records[next]);
+  std::this_thread::sleep_until(std::min(dueTime, deadline));
+  return dueTime <= deadline;
+}
@@ -0,0 +1,56 @@
+#ifndef REPLAY_TRANSPORT_HPP
+#define REPLAY_TRANSPORT_HPP
+
+#include <string>
+#include "basic_transport.hpp"
+#include "frame_log.hpp"
+
+namespace kot_motor::transport {
+
+// Feeds the received frames of a frame log back, e.g. to run the
+// controllers of a field run again. The log is mmapped, so even a large
+// one costs no parsing. The frames come at their original timing scaled
+// by the speed, or all at once with AS_FAST_AS_POSSIBLE. The commands
+// written to it are accepted and dropped.
+class ReplayTransport : public BasicTransport {
+public:
+  static constexpr float AS_FAST_AS_POSSIBLE = 0.0f;
+
+public:
+  ReplayTransport(const std::string & path, float speed = 1.0f);
+  ReplayTransport(const ReplayTransport &) = delete;
+  ReplayTransport & operator=(const ReplayTransport &) = delete;
+  ~ReplayTransport();
+
+  Status open();
+  Status close();
+
+  // Replay control
+  void restart() noexcept;
+  bool finished() const noexcept;
+  size_t recordsCount() const noexcept;
+
+  Status write(const CanFrame & canFrame) override;
+  std::optional<CanFrame> read() override;
+  bool wait(std::chrono::microseconds timeout) override;
+
+private:
+  bool nextReceived() noexcept;
+  CanFrame::Clock::time_point due(const frame_log::Record & record) const noexcept;
+
+private:
+  const std::string path;
+  const float speed;
+
+  void * mapping = nullptr;
+  size_t mappingSize = 0;
+  const frame_log::Record * records = nullptr;
+  size_t recordsN = 0;
+
+  size_t next = 0; // the next received record to be fed
+  CanFrame::Clock::time_point started;
+};
+
+} // namespace kot_motor::transport
+
+#endif // REPLAY_TRANSPORT_HPP
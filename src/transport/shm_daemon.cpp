@@ -0,0 +1,242 @@
+#include <new>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "shm_daemon.hpp"
+
+using kot_motor::transport::ShmDaemon;
+using namespace kot_motor::transport::shm;
+
+ShmDaemon::ShmDaemon(BasicTransport & bus, const std::string & name)
+  : bus(bus)
+  , name(name)
+{ }
+
+ShmDaemon::~ShmDaemon()
+{
+  stop();
+  close();
+}
+
+ShmDaemon::Status ShmDaemon::open()
+{
+  if (segment != nullptr) {
+    return Status::FAIL;
+  }
+
+  pid = getpid();
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+  if (fd == -1 and errno == EEXIST and !isServed()) {
+    // left by a crashed daemon, its clients keep it until they reopen
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+  }
+  if (fd == -1) {
+    return Status::INIT_FAIL;
+  }
+  if (ftruncate(fd, sizeof(Segment)) == -1) {
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return Status::INIT_FAIL;
+  }
+  void * memory = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return Status::INIT_FAIL;
+  }
+
+  segment = new (memory) Segment();
+  segment->bitrate.store(bus.busLoad().bitrate(), std::memory_order_relaxed);
+  segment->frameTimeNs.store(bus.frameTime().count(), std::memory_order_relaxed);
+  segment->daemon.store(pid, std::memory_order_relaxed);
+  segment->magic.store(MAGIC, std::memory_order_release);
+  return Status::SUCCESS_INIT;
+}
+
+ShmDaemon::Status ShmDaemon::close()
+{
+  if (segment == nullptr or running.load()) {
+    return Status::FAIL;
+  }
+
+  for (size_t canId = 0; canId < attached.size(); canId++) {
+    if (attached[canId]) {
+      bus.detachMotor(canId, masters[canId]);
+      attached[canId] = false;
+    }
+  }
+
+  // the clients fail their writes from now on
+  segment->running.store(0, std::memory_order_release);
+  munmap(segment, sizeof(Segment));
+  segment = nullptr;
+  shm_unlink(name.c_str());
+  return Status::SUCCESS;
+}
+
+ShmDaemon::Status ShmDaemon::start(std::chrono::microseconds idleWait)
+{
+  if (segment == nullptr or running.load()) {
+    return Status::FAIL;
+  }
+
+  running = true;
+  segment->running.store(1, std::memory_order_release);
+  worker = std::thread(&ShmDaemon::run, this, idleWait);
+  return Status::SUCCESS_INIT;
+}
+
+ShmDaemon::Status ShmDaemon::stop()
+{
+  if (!running.exchange(false)) {
+    return Status::FAIL;
+  }
+  worker.join();
+  segment->running.store(0, std::memory_order_release);
+  return Status::SUCCESS;
+}
+
+bool ShmDaemon::isRunning() const noexcept
+{
+  return running.load();
+}
+
+size_t ShmDaemon::poll()
+{
+  if (segment == nullptr) {
+    return 0;
+  }
+
+  // a calibration of the bus is seen by the clients
+  segment->frameTimeNs.store(bus.frameTime().count(), std::memory_order_relaxed);
+
+  size_t moved = 0;
+  size_t pendingN = 0;
+  for (size_t canId = 0; canId < segment->motors.size(); canId++) {
+    MotorSlot & slot = segment->motors[canId];
+    syncAttachment(canId, slot);
+    if (!attached[canId]) {
+      continue;
+    }
+
+    // a version with no frame is a store left to a later pass
+    CanFrame canFrame;
+    if (slot.urgent.version() != slot.urgentTaken.load(std::memory_order_relaxed)) {
+      // supersedes the unsent regular command, an unsent mode frame goes
+      // out ahead of it
+      CanFrame command;
+      uint32_t version = slot.command.load(command);
+      if (version != slot.commandTaken.load(std::memory_order_relaxed) and FrameSlot::isComplete(version)) {
+        slot.commandTaken.store(version, std::memory_order_release);
+        if (isModeFrame(command)) {
+          bus.writeUrgent(command);
+          moved++;
+        }
+      }
+
+      version = slot.urgent.load(canFrame);
+      slot.urgentTaken.store(version, std::memory_order_release);
+      if (FrameSlot::isComplete(version)) {
+        bus.writeUrgent(canFrame);
+        moved++;
+      }
+    } else if (slot.command.version() != slot.commandTaken.load(std::memory_order_relaxed)) {
+      uint32_t version = slot.command.load(canFrame);
+      slot.commandTaken.store(version, std::memory_order_release);
+      if (FrameSlot::isComplete(version)) {
+        pending[pendingN++] = canFrame;
+      }
+    }
+  }
+
+  // the commands the bus refuses are lost, the clients send new ones
+  // every cycle and the failures are in the statistics of the bus
+  moved += bus.writeBatch(pending.data(), pendingN);
+  moved += publishReplies();
+  return moved;
+}
+
+/********************************* Internals *********************************/
+
+void ShmDaemon::run(std::chrono::microseconds idleWait)
+{
+  while (running.load(std::memory_order_relaxed)) {
+    if (poll() == 0) {
+      bus.wait(idleWait);
+    }
+  }
+}
+
+void ShmDaemon::syncAttachment(uint8_t canId, MotorSlot & slot) noexcept
+{
+  bool used = slot.users.load(std::memory_order_acquire) > 0;
+  if (used == attached[canId]) {
+    return;
+  }
+
+  if (used) {
+    masters[canId] = slot.masterCanId.load(std::memory_order_relaxed);
+    bus.attachMotor(canId, masters[canId]);
+  } else {
+    bus.detachMotor(canId, masters[canId]);
+    // the commands left unsent would be outdated by the next attachment
+    CanFrame canFrame;
+    slot.commandTaken.store(slot.command.load(canFrame), std::memory_order_release);
+    slot.urgentTaken.store(slot.urgent.load(canFrame), std::memory_order_release);
+  }
+  attached[canId] = used;
+}
+
+bool ShmDaemon::isServed() const noexcept
+{
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat info;
+  void * memory = MAP_FAILED;
+  if (fstat(fd, &info) != -1 and size_t(info.st_size) >= sizeof(Segment)) {
+    memory = mmap(nullptr, sizeof(Segment), PROT_READ, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+
+  // the pid of an older layout is not known, it is taken as stale
+  auto other = static_cast<const Segment *>(memory);
+  bool served = other->magic.load(std::memory_order_acquire) == MAGIC and other->version == VERSION
+    and isAlive(other->daemon.load(std::memory_order_relaxed));
+  munmap(memory, sizeof(Segment));
+  return served;
+}
+
+size_t ShmDaemon::publishReplies() noexcept
+{
+  bus.receive();
+
+  size_t published = 0;
+  for (size_t canId = 0; canId < attached.size(); canId++) {
+    if (!attached[canId]) {
+      continue;
+    }
+    if (auto reply = bus.takeReply(canId)) {
+      segment->motors[canId].reply.store(reply.value(), pid);
+      published++;
+    }
+  }
+
+  if (published > 0) {
+    segment->feedbackEpoch.fetch_add(1, std::memory_order_seq_cst);
+    if (segment->waiters.load(std::memory_order_seq_cst) > 0) {
+      syscall(SYS_futex, &segment->feedbackEpoch, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+    }
+  }
+  return published;
+}
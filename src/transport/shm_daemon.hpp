@@ -0,0 +1,76 @@
+#ifndef SHM_DAEMON_HPP
+#define SHM_DAEMON_HPP
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "basic_transport.hpp"
+#include "shm_segment.hpp"
+
+namespace kot_motor::transport {
+
+// Shares a transport with other processes through a POSIX shared memory
+// segment. Each motor has a command slot per lane and a feedback slot
+// there, all of them latest-value seqlocks. The clients are ShmTransports.
+// The daemon sends the commands stored since its last pass, an urgent
+// one supersedes the regular one of its motor. Mode frames are never
+// superseded, a client storing over an unsent one waits for the daemon
+// to take it. Every reply of an attached motor is stored, so each client
+// sees it with no frame duplicated on the bus. A motor stays attached to
+// the bus while some client has it attached.
+class ShmDaemon {
+public:
+  using Status = BasicTransport::Status;
+  using CanFrame = BasicTransport::CanFrame;
+
+  static constexpr std::chrono::microseconds DEFAULT_IDLE_WAIT{100};
+
+public:
+  // `name` is the name of the segment, "/kot_motor_can0" for instance
+  ShmDaemon(BasicTransport & bus, const std::string & name);
+  ShmDaemon(const ShmDaemon &) = delete;
+  ShmDaemon & operator=(const ShmDaemon &) = delete;
+  ~ShmDaemon();
+
+  // Creates the segment, replacing a stale one left by a crashed daemon.
+  // Fails while another daemon serves the name.
+  Status open();
+  Status close();
+
+  // Serves the clients from a thread of its own, `idleWait` is the most
+  // a command may wait while the bus is quiet
+  Status start(std::chrono::microseconds idleWait = DEFAULT_IDLE_WAIT);
+  Status stop();
+  bool isRunning() const noexcept;
+
+  // One pass for a caller with a loop of its own: the attachments, the
+  // commands and the replies. Returns the number of frames moved.
+  size_t poll();
+
+private:
+  void run(std::chrono::microseconds idleWait);
+  bool isServed() const noexcept;
+  void syncAttachment(uint8_t canId, shm::MotorSlot & slot) noexcept;
+  size_t publishReplies() noexcept;
+
+private:
+  BasicTransport & bus;
+  const std::string name;
+
+  shm::Segment * segment = nullptr;
+  // the writer of the replies
+  pid_t pid = 0;
+
+  std::thread worker;
+  std::atomic<bool> running{false};
+
+  // the motors attached to the bus on behalf of the clients
+  std::array<bool, 256> attached = {};
+  std::array<uint8_t, 256> masters = {};
+  std::array<CanFrame, 256> pending;
+};
+
+} // namespace kot_motor::transport
+
+#endif // SHM_DAEMON_HPP
@@ -0,0 +1,156 @@
+#ifndef SHM_SEGMENT_HPP
+#define SHM_SEGMENT_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include "basic_transport.hpp"
+
+namespace kot_motor::transport::shm {
+
+using CanFrame = BasicTransport::CanFrame;
+
+constexpr uint32_t MAGIC = 0x6b6f746d; // "kotm"
+constexpr uint32_t VERSION = 2;
+
+static_assert(std::is_trivially_copyable_v<CanFrame>);
+static_assert(sizeof(CanFrame) % sizeof(uint64_t) == 0);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(std::atomic<pid_t>::is_always_lock_free);
+
+// Whether a process still exists, the holder of a slot or the daemon
+// of a segment may have died holding it
+inline bool isAlive(pid_t pid) noexcept
+{
+  return kill(pid, 0) == 0 or errno != ESRCH;
+}
+
+// The latest frame behind a seqlock, shared between processes. Any
+// process may store, the writers take turns by holding `owner`, a
+// slot held by a dead writer is taken over by the next one. Readers
+// never block anybody, they retry a load torn by a store for a while.
+// The frame is kept in atomic words, so a torn read is only a retry.
+class FrameSlot {
+public:
+  static constexpr size_t WORDS = sizeof(CanFrame) / sizeof(uint64_t);
+  // the retries of a writer between checks of the holder
+  static constexpr uint32_t OWNER_SPINS = 1 << 10;
+  // the retries of a reader before giving up on a store in progress
+  static constexpr uint32_t LOAD_SPINS = 1 << 16;
+
+public:
+  void store(const CanFrame & canFrame, pid_t writer) noexcept
+  {
+    pid_t holder = 0;
+    for (uint32_t spins = 1; !owner.compare_exchange_weak(holder, writer, std::memory_order_acquire); spins++) {
+      // the holder stays expected while dead, the next exchange takes over
+      if (holder != 0 and spins % OWNER_SPINS == 0 and !isAlive(holder)) {
+        continue;
+      }
+      holder = 0;
+    }
+
+    // already odd when the holder died storing
+    uint32_t seq = sequence.load(std::memory_order_relaxed) | 1;
+    sequence.store(seq, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    uint64_t raw[WORDS];
+    std::memcpy(raw, static_cast<const void *>(&canFrame), sizeof(raw));
+    for (size_t i = 0; i < WORDS; i++) {
+      words[i].store(raw[i], std::memory_order_relaxed);
+    }
+    sequence.store(seq + 1, std::memory_order_release);
+    owner.store(0, std::memory_order_release);
+  }
+
+  // Returns the version of the loaded frame, 0 if nothing was stored yet.
+  // An odd version is a store that did not end in time, its writer slow
+  // or dead: `canFrame` is left as is, a later version has the frame.
+  uint32_t load(CanFrame & canFrame) const noexcept
+  {
+    uint64_t raw[WORDS];
+    uint32_t before = 0;
+    uint32_t after = 0;
+    uint32_t spins = 0;
+    do {
+      before = sequence.load(std::memory_order_acquire);
+      if (before & 1) {
+        if (++spins == LOAD_SPINS) {
+          return before;
+        }
+        continue;
+      }
+      for (size_t i = 0; i < WORDS; i++) {
+        raw[i] = words[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      after = sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) or before != after);
+
+    std::memcpy(static_cast<void *>(&canFrame), raw, sizeof(raw));
+    return before;
+  }
+
+  // Changes with every store, even while no store is in progress
+  uint32_t version() const noexcept
+  {
+    return sequence.load(std::memory_order_acquire);
+  }
+
+  // Whether a version returned by load() comes with a frame
+  static constexpr bool isComplete(uint32_t version) noexcept
+  {
+    return (version & 1) == 0;
+  }
+
+private:
+  std::atomic<uint32_t> sequence{0};
+  std::atomic<pid_t> owner{0};
+  std::array<std::atomic<uint64_t>, WORDS> words = {};
+};
+
+// Everything shared about a motor: how many client transports attached
+// it, its last command in each lane with the version the daemon took
+// last and its last reply. A cache line of its own, the motors are
+// driven by different processes.
+struct alignas(64) MotorSlot {
+  std::atomic<uint32_t> users{0};
+  std::atomic<uint32_t> masterCanId{0};
+  FrameSlot command;
+  FrameSlot urgent;
+  std::atomic<uint32_t> commandTaken{0};
+  std::atomic<uint32_t> urgentTaken{0};
+  FrameSlot reply;
+};
+
+// The shared memory segment, created by the daemon. The rest of the
+// header is fixed once `magic` is set.
+struct Segment {
+  std::atomic<uint32_t> magic{0};
+  uint32_t version = VERSION;
+
+  std::atomic<uint32_t> running{0};
+  // the process of the daemon, a live one keeps its segment
+  std::atomic<pid_t> daemon{0};
+  // bumped by the daemon after publishing replies, a futex to wait on
+  std::atomic<uint32_t> feedbackEpoch{0};
+  std::atomic<uint32_t> waiters{0};
+
+  // timing of the bus, as reported by the daemon's transport
+  std::atomic<uint32_t> bitrate{0};
+  std::atomic<int64_t> frameTimeNs{0};
+
+  std::array<MotorSlot, 256> motors;
+};
+
+} // namespace kot_motor::transport::shm
+
+#endif // SHM_SEGMENT_HPP
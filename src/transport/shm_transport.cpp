@@ -0,0 +1,234 @@
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "shm_transport.hpp"
+
+using kot_motor::transport::ShmTransport;
+using kot_motor::transport::BusLoad;
+using namespace kot_motor::transport::shm;
+
+ShmTransport::ShmTransport(const std::string & name)
+  : name(name)
+{ }
+
+ShmTransport::~ShmTransport()
+{
+  close();
+}
+
+ShmTransport::Status ShmTransport::open()
+{
+  if (segment != nullptr) {
+    return Status::FAIL;
+  }
+
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd == -1) {
+    return Status::INIT_FAIL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == -1 or size_t(info.st_size) < sizeof(Segment)) {
+    ::close(fd);
+    return Status::INIT_FAIL;
+  }
+  void * memory = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    return Status::INIT_FAIL;
+  }
+
+  auto mapped = static_cast<Segment *>(memory);
+  if (mapped->magic.load(std::memory_order_acquire) != MAGIC or mapped->version != VERSION) {
+    munmap(memory, sizeof(Segment));
+    return Status::INIT_FAIL;
+  }
+  segment = mapped;
+  pid = getpid();
+
+  // the motors attached before the opening
+  for (size_t canId = 0; canId < users.size(); canId++) {
+    if (users[canId] > 0) {
+      segment->motors[canId].users.fetch_add(users[canId], std::memory_order_acq_rel);
+      lastReply[canId] = segment->motors[canId].reply.version();
+    }
+  }
+  return Status::SUCCESS_INIT;
+}
+
+ShmTransport::Status ShmTransport::close()
+{
+  if (segment == nullptr) {
+    return Status::FAIL;
+  }
+
+  for (size_t canId = 0; canId < users.size(); canId++) {
+    if (users[canId] > 0) {
+      segment->motors[canId].users.fetch_sub(users[canId], std::memory_order_acq_rel);
+    }
+  }
+  munmap(segment, sizeof(Segment));
+  segment = nullptr;
+  return Status::SUCCESS;
+}
+
+bool ShmTransport::isConnected() const noexcept
+{
+  return segment != nullptr and segment->running.load(std::memory_order_acquire) != 0;
+}
+
+ShmTransport::Status ShmTransport::write(const CanFrame & canFrame)
+{
+  return store(&MotorSlot::command, &MotorSlot::commandTaken, canFrame);
+}
+
+ShmTransport::Status ShmTransport::writeUrgent(const CanFrame & canFrame)
+{
+  return store(&MotorSlot::urgent, &MotorSlot::urgentTaken, canFrame);
+}
+
+std::optional<ShmTransport::CanFrame> ShmTransport::read()
+{
+  if (segment == nullptr) {
+    return {};
+  }
+
+  for (size_t i = 0; i < users.size(); i++) {
+    size_t canId = (nextMotor + i) % users.size();
+    if (users[canId] == 0) {
+      continue;
+    }
+    const FrameSlot & reply = segment->motors[canId].reply;
+    if (reply.version() == lastReply[canId]) {
+      continue;
+    }
+
+    // a reply the daemon did not end storing is skipped
+    CanFrame canFrame;
+    lastReply[canId] = reply.load(canFrame);
+    if (!FrameSlot::isComplete(lastReply[canId])) {
+      continue;
+    }
+    nextMotor = canId + 1;
+    countReceived(1);
+    return canFrame;
+  }
+  return {};
+}
+
+bool ShmTransport::wait(std::chrono::microseconds timeout)
+{
+  if (segment == nullptr) {
+    return false;
+  }
+
+  auto deadline = CanFrame::Clock::now() + timeout;
+  while (true) {
+    // taken before the check, a publication after it makes the futex return
+    uint32_t epoch = segment->feedbackEpoch.load(std::memory_order_seq_cst);
+    if (hasFeedback()) {
+      return true;
+    }
+
+    auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - CanFrame::Clock::now());
+    if (left.count() <= 0) {
+      return false;
+    }
+    struct timespec relative = {time_t(left.count() / 1000000000), long(left.count() % 1000000000)};
+
+    segment->waiters.fetch_add(1, std::memory_order_seq_cst);
+    syscall(SYS_futex, &segment->feedbackEpoch, FUTEX_WAIT, epoch, &relative, nullptr, 0);
+    segment->waiters.fetch_sub(1, std::memory_order_seq_cst);
+  }
+}
+
+void ShmTransport::attachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::attachMotor(canId, masterCanId);
+  users[canId]++;
+  if (segment != nullptr) {
+    MotorSlot & slot = segment->motors[canId];
+    slot.masterCanId.store(masterCanId, std::memory_order_relaxed);
+    slot.users.fetch_add(1, std::memory_order_acq_rel);
+    if (users[canId] == 1) {
+      // no reply older than the attachment
+      lastReply[canId] = slot.reply.version();
+    }
+  }
+}
+
+void ShmTransport::detachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::detachMotor(canId, masterCanId);
+  if (users[canId] == 0) {
+    return;
+  }
+  users[canId]--;
+  if (segment != nullptr) {
+    segment->motors[canId].users.fetch_sub(1, std::memory_order_acq_rel);
+  }
+}
+
+BusLoad ShmTransport::busLoad() const noexcept
+{
+  if (segment == nullptr) {
+    return BasicTransport::busLoad();
+  }
+  return BusLoad(segment->bitrate.load(std::memory_order_relaxed));
+}
+
+std::chrono::nanoseconds ShmTransport::frameTime() const noexcept
+{
+  if (segment == nullptr) {
+    return BasicTransport::frameTime();
+  }
+  return std::chrono::nanoseconds(segment->frameTimeNs.load(std::memory_order_relaxed));
+}
+
+/********************************* Internals *********************************/
+
+ShmTransport::Status ShmTransport::store(
+  FrameSlot MotorSlot::* lane,
+  std::atomic<uint32_t> MotorSlot::* taken,
+  const CanFrame & canFrame
+) noexcept
+{
+  // only the attached motors are served by the daemon
+  if (!isConnected() or canFrame.canId >= users.size() or users[canFrame.canId] == 0) {
+    countWriteFailures(&canFrame, 1);
+    return Status::FAIL;
+  }
+
+  MotorSlot & slot = segment->motors[canFrame.canId];
+  auto deadline = CanFrame::Clock::now() + MODE_FRAME_TIMEOUT;
+  CanFrame unsent;
+  while (true) {
+    uint32_t version = (slot.*lane).load(unsent);
+    bool sent = version == (slot.*taken).load(std::memory_order_acquire);
+    if (sent or !FrameSlot::isComplete(version) or !isModeFrame(unsent)) {
+      break;
+    }
+    if (CanFrame::Clock::now() >= deadline or !isConnected()) {
+      countWriteFailures(&canFrame, 1);
+      return Status::FAIL;
+    }
+    std::this_thread::yield();
+  }
+
+  (slot.*lane).store(canFrame, pid);
+  countSent(&canFrame, 1);
+  return Status::SUCCESS;
+}
+
+bool ShmTransport::hasFeedback() const noexcept
+{
+  for (size_t canId = 0; canId < users.size(); canId++) {
+    if (users[canId] > 0 and segment->motors[canId].reply.version() != lastReply[canId]) {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,66 @@
+#ifndef SHM_TRANSPORT_HPP
+#define SHM_TRANSPORT_HPP
+
+#include <array>
+#include <string>
+#include "basic_transport.hpp"
+#include "shm_segment.hpp"
+
+namespace kot_motor::transport {
+
+// Client of a ShmDaemon, drives the motors of the daemon's bus from
+// another process. A write stores the command into the slot of its
+// motor, replacing the one the daemon hasn't sent yet unless that one
+// is a mode frame, which is waited out. read() returns the replies
+// stored since the last read, one per motor, and wait() sleeps on a
+// futex until the daemon publishes new ones.
+// Motors have to be attached to be commanded and to get replies.
+class ShmTransport : public BasicTransport {
+public:
+  // the most a write waits for the daemon to take an unsent mode frame
+  static constexpr std::chrono::milliseconds MODE_FRAME_TIMEOUT{10};
+
+public:
+  ShmTransport(const std::string & name);
+  ShmTransport(const ShmTransport &) = delete;
+  ShmTransport & operator=(const ShmTransport &) = delete;
+  ~ShmTransport();
+
+  // Maps the segment of a running daemon
+  Status open();
+  Status close();
+  bool isConnected() const noexcept;
+
+  Status write(const CanFrame & canFrame) override;
+  Status writeUrgent(const CanFrame & canFrame) override;
+  std::optional<CanFrame> read() override;
+  bool wait(std::chrono::microseconds timeout) override;
+
+  void attachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+  void detachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+
+  // The timing of the daemon's bus
+  BusLoad busLoad() const noexcept override;
+  std::chrono::nanoseconds frameTime() const noexcept override;
+
+private:
+  Status store(
+    shm::FrameSlot shm::MotorSlot::* lane,
+    std::atomic<uint32_t> shm::MotorSlot::* taken,
+    const CanFrame & canFrame
+  ) noexcept;
+  bool hasFeedback() const noexcept;
+
+private:
+  const std::string name;
+  shm::Segment * segment = nullptr;
+  pid_t pid = 0; // the writer of the commands
+
+  std::array<uint16_t, 256> users = {};     // attachments by this client
+  std::array<uint32_t, 256> lastReply = {}; // versions of the replies read
+  size_t nextMotor = 0;                     // the replies are read round robin
+};
+
+} // namespace kot_motor::transport
+
+#endif // SHM_TRANSPORT_HPP
@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "simulated_motor_transport.hpp"
+
+using kot_motor::transport::SimulatedMotorTransport;
+using namespace kot_motor::dimensions;
+
+namespace {
+
+constexpr uint8_t ENTER_MOTOR_MODE = 0xFC;
+constexpr uint8_t EXIT_MOTOR_MODE = 0xFD;
+constexpr uint8_t SET_ZERO = 0xFE;
+
+template <typename Unit>
+float decode(uint32_t code, const kot_motor::motor::Limits<Unit> & limits, uint8_t bits)
+{
+  float min = float(limits.min);
+  float max = float(limits.max);
+  return float(code) * (max - min) / float((1u << bits) - 1) + min;
+}
+
+template <typename Unit>
+uint32_t encode(float x, const kot_motor::motor::Limits<Unit> & limits, uint8_t bits)
+{
+  float min = float(limits.min);
+  float max = float(limits.max);
+  x = std::clamp(x, min, max);
+  return uint32_t((x - min) * float((1u << bits) - 1) / (max - min));
+}
+
+} // namespace
+
+SimulatedMotorTransport::SimulatedMotorTransport()
+  : SimulatedMotorTransport(Options{})
+{ }
+
+SimulatedMotorTransport::SimulatedMotorTransport(const Options & options)
+  : options(options)
+  , motors()
+  , replies()
+  , start(CanFrame::Clock::now())
+  , random(options.seed)
+  , drop(std::clamp(options.dropRate, 0.0f, 1.0f))
+{ }
+
+void SimulatedMotorTransport::addMotor(
+  uint8_t canId, uint8_t masterCanId, const motor::Motor::MotorLimits & limits
+)
+{
+  addMotor(canId, masterCanId, limits, PlantModel{});
+}
+
+void SimulatedMotorTransport::addMotor(
+  uint8_t canId,
+  uint8_t masterCanId,
+  const motor::Motor::MotorLimits & limits,
+  const PlantModel & plant
+)
+{
+  SimMotor & motor = motors[canId];
+  motor = SimMotor{};
+  motor.present = true;
+  motor.masterCanId = masterCanId;
+  motor.limits = limits;
+  motor.plant = plant;
+}
+
+/***************************** Simulated time ******************************/
+
+void SimulatedMotorTransport::advance(std::chrono::nanoseconds dt)
+{
+  elapsed += dt;
+
+  const std::chrono::nanoseconds step = options.step;
+  const float stepSec = std::chrono::duration<float>(step).count();
+  while (integrated + step <= elapsed) {
+    for (auto && motor : motors) {
+      if (motor.present) {
+        integrate(motor, stepSec);
+      }
+    }
+    integrated += step;
+  }
+}
+
+SimulatedMotorTransport::CanFrame::Clock::time_point SimulatedMotorTransport::now() const noexcept
+{
+  return start + std::chrono::duration_cast<CanFrame::Clock::duration>(elapsed);
+}
+
+void SimulatedMotorTransport::syncRealTime()
+{
+  if (options.realTime) {
+    auto realElapsed = CanFrame::Clock::now() - start;
+    if (realElapsed > elapsed) {
+      advance(realElapsed - elapsed);
+    }
+  }
+}
+
+/************************** Simulated motor state ***************************/
+
+Radian SimulatedMotorTransport::position(uint8_t canId) const
+{
+  return motors[canId].position;
+}
+
+AngularVelocity SimulatedMotorTransport::velocity(uint8_t canId) const
+{
+  return motors[canId].velocity;
+}
+
+Torque SimulatedMotorTransport::torque(uint8_t canId) const
+{
+  return motors[canId].torque;
+}
+
+bool SimulatedMotorTransport::enabled(uint8_t canId) const
+{
+  return motors[canId].enabled;
+}
+
+/******************************** Transport ********************************/
+
+SimulatedMotorTransport::Status SimulatedMotorTransport::write(const CanFrame & canFrame)
+{
+  syncRealTime();
+  countSent(&canFrame, 1, now());
+
+  if (canFrame.canId >= motors.size()) {
+    return Status::SUCCESS;
+  }
+
+  SimMotor & motor = motors[canFrame.canId];
+  if (!motor.present) {
+    return Status::SUCCESS; // nobody on the bus answers
+  }
+
+  if (isModeFrame(canFrame)) {
+    switch (canFrame.data[7]) {
+      case ENTER_MOTOR_MODE:
+        motor.enabled = true;
+        break;
+      case EXIT_MOTOR_MODE:
+        motor.enabled = false;
+        break;
+      case SET_ZERO:
+        motor.position = 0;
+        break;
+    }
+  } else if (canFrame.size == 8 and motor.enabled) {
+    decodeCommand(motor, canFrame.data);
+  }
+
+  // the firmware answers every frame with its state
+  if (!drop(random)) {
+    auto latency = std::chrono::duration_cast<CanFrame::Clock::duration>(options.latency);
+    replies.push_back({now() + latency, encodeReply(canFrame.canId, motor)});
+  }
+
+  return Status::SUCCESS;
+}
+
+std::optional<SimulatedMotorTransport::CanFrame> SimulatedMotorTransport::read()
+{
+  syncRealTime();
+
+  if (replies.empty() or replies.front().due > now()) {
+    return {};
+  }
+
+  CanFrame canFrame = replies.front().frame;
+  canFrame.timestamp = replies.front().due;
+  replies.pop_front();
+  countReceived(1);
+  return canFrame;
+}
+
+bool SimulatedMotorTransport::wait(std::chrono::microseconds timeout)
+{
+  syncRealTime();
+
+  auto deadline = now() + timeout;
+  bool ready = !replies.empty() and replies.front().due <= deadline;
+  auto until = ready ? std::max(replies.front().due, now()) : deadline;
+
+  if (options.realTime) {
+    std::this_thread::sleep_until(until);
+    syncRealTime();
+  } else {
+    advance(until - now());
+  }
+
+  return ready;
+}
+
+/********************************** Plant **********************************/
+
+void SimulatedMotorTransport::integrate(SimMotor & motor, float dt) const noexcept
+{
+  float torque = 0;
+  if (motor.enabled) {
+    torque = motor.kp * (motor.pDes - motor.position) +
+      motor.kd * (motor.vDes - motor.velocity) + motor.tFf;
+    torque = std::clamp(torque, float(motor.limits.torque.min), float(motor.limits.torque.max));
+  }
+  motor.torque = torque;
+
+  const PlantModel & plant = motor.plant;
+  float coulomb = float(plant.coulombFriction);
+  float friction = -float(plant.viscousFriction) * motor.velocity;
+
+  if (motor.velocity == 0 and std::abs(torque) <= coulomb) {
+    return; // sticking
+  }
+
+  float velocity = motor.velocity;
+  friction -= std::copysign(coulomb, velocity != 0 ? velocity : torque);
+  velocity += (torque + friction) / plant.inertia * dt;
+
+  // the coulomb friction stops the shaft, it never reverses it
+  if (motor.velocity != 0 and std::signbit(velocity) != std::signbit(motor.velocity) and
+      std::abs(torque) <= coulomb) {
+    velocity = 0;
+  }
+
+  motor.velocity = velocity;
+  motor.position += velocity * dt;
+}
+
+void SimulatedMotorTransport::decodeCommand(SimMotor & motor, const uint8_t * data) const noexcept
+{
+  uint32_t p_int = (data[0] << 8) | data[1];
+  uint32_t v_int = (data[2] << 4) | (data[3] >> 4);
+  uint32_t kp_int = ((data[3] & 0xF) << 8) | data[4];
+  uint32_t kd_int = (data[5] << 4) | (data[6] >> 4);
+  uint32_t t_int = ((data[6] & 0xF) << 8) | data[7];
+
+  motor.pDes = decode(p_int, motor.limits.position, 16);
+  motor.vDes = decode(v_int, motor.limits.velocity, 12);
+  motor.kp = decode(kp_int, motor.limits.stiffness, 12);
+  motor.kd = decode(kd_int, motor.limits.damper, 12);
+  motor.tFf = decode(t_int, motor.limits.torque, 12);
+}
+
+SimulatedMotorTransport::CanFrame
+  SimulatedMotorTransport::encodeReply(uint8_t canId, const SimMotor & motor) const noexcept
+{
+  uint32_t p_int = encode(motor.position, motor.limits.position, 16);
+  uint32_t v_int = encode(motor.velocity, motor.limits.velocity, 12);
+  uint32_t i_int = encode(motor.torque, motor.limits.torque, 12);
+
+  uint8_t buff[6];
+  buff[0] = canId;
+  buff[1] = p_int >> 8;
+  buff[2] = p_int & 0xFF;
+  buff[3] = v_int >> 4;
+  buff[4] = ((v_int & 0xF) << 4) | (i_int >> 8);
+  buff[5] = i_int & 0xFF;
+
+  return CanFrame{motor.masterCanId, buff, sizeof(buff)};
+}
@@ -0,0 +1,113 @@
+#ifndef SIMULATED_MOTOR_TRANSPORT_HPP
+#define SIMULATED_MOTOR_TRANSPORT_HPP
+
+#include <array>
+#include <deque>
+#include <random>
+#include "basic_transport.hpp"
+#include "motor/motor.hpp"
+
+namespace kot_motor::transport {
+
+// A bus with simulated MIT Mini Cheetah motors on it, no hardware needed.
+// Every command frame is decoded like the firmware does (including the
+// 0xFC/0xFD/0xFE mode frames), a PD + inertia + friction plant is run per
+// motor and the encoded state reply comes back after the configured
+// latency, unless it gets dropped.
+//
+// By default the time is simulated: it only advances by advance() and
+// wait(), which jumps straight to the next reply instead of sleeping, so
+// control loops built on wait() run faster than real time.
+class SimulatedMotorTransport : public BasicTransport {
+public:
+  struct PlantModel {
+    float inertia = 0.005f;                     // kg*m^2, at the output shaft
+    dimensions::RotationalDamping viscousFriction = 0.01f;
+    dimensions::Torque coulombFriction = 0.05f;
+  };
+
+  struct Options {
+    std::chrono::microseconds latency{200};  // from a command to its reply
+    float dropRate = 0.0f;                    // probability of a reply being lost
+    std::chrono::microseconds step{50};      // plant integration step
+    bool realTime = false;                    // the time follows the steady clock
+    uint32_t seed = 1;                        // of the drop generator
+  };
+
+public:
+  SimulatedMotorTransport();
+  SimulatedMotorTransport(const Options & options);
+
+  void addMotor(
+    uint8_t canId,
+    uint8_t masterCanId,
+    const motor::Motor::MotorLimits & limits
+  );
+  void addMotor(
+    uint8_t canId,
+    uint8_t masterCanId,
+    const motor::Motor::MotorLimits & limits,
+    const PlantModel & plant
+  );
+
+  // Simulated time control
+  void advance(std::chrono::nanoseconds dt);
+  CanFrame::Clock::time_point now() const noexcept override;
+
+  // State of a simulated motor, for checking the controllers against
+  dimensions::Radian position(uint8_t canId) const;
+  dimensions::AngularVelocity velocity(uint8_t canId) const;
+  dimensions::Torque torque(uint8_t canId) const;
+  bool enabled(uint8_t canId) const;
+
+  Status write(const CanFrame & canFrame) override;
+  std::optional<CanFrame> read() override;
+  bool wait(std::chrono::microseconds timeout) override;
+
+private:
+  struct SimMotor {
+    bool present = false;
+    uint8_t masterCanId = 0;
+    motor::Motor::MotorLimits limits;
+    PlantModel plant;
+
+    bool enabled = false;
+    float position = 0;
+    float velocity = 0;
+    float torque = 0;
+
+    // the last command
+    float pDes = 0;
+    float vDes = 0;
+    float kp = 0;
+    float kd = 0;
+    float tFf = 0;
+  };
+
+  struct PendingReply {
+    CanFrame::Clock::time_point due;
+    CanFrame frame;
+  };
+
+private:
+  void syncRealTime();
+  void integrate(SimMotor & motor, float dt) const noexcept;
+  void decodeCommand(SimMotor & motor, const uint8_t * data) const noexcept;
+  CanFrame encodeReply(uint8_t canId, const SimMotor & motor) const noexcept;
+
+private:
+  Options options;
+  std::array<SimMotor, 256> motors;
+  std::deque<PendingReply> replies; // ordered by due time, the latency is constant
+
+  CanFrame::Clock::time_point start;
+  std::chrono::nanoseconds elapsed{0};    // simulated time
+  std::chrono::nanoseconds integrated{0}; // time the plants were integrated up to
+
+  std::mt19937 random;
+  std::bernoulli_distribution drop;
+};
+
+} // namespace kot_motor::transport
+
+#endif // SIMULATED_MOTOR_TRANSPORT_HPP
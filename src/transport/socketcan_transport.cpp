@@ -2,13 +2,60 @@
 #include <cstdint>
 #include <cstring>
 #include <algorithm>
+#include <cerrno>
+#include <poll.h>
+#include <vector>
+#include <cstddef>
 #include "socketcan_transport.hpp"
+#include "kernel_timestamp.hpp"
 
 using kot_motor::transport::SocketCanTransport;
+namespace kernel_timestamp = kot_motor::transport::kernel_timestamp;
 
-SocketCanTransport::SocketCanTransport(const std::string& canName) 
+namespace {
+
+using CanFrame = SocketCanTransport::CanFrame;
+
+// CanFrame starts with a struct can_frame, the kernel reads and writes it in place
+static_assert(offsetof(CanFrame, canId) == offsetof(struct can_frame, can_id));
+static_assert(offsetof(CanFrame, size) == offsetof(struct can_frame, len));
+static_assert(offsetof(CanFrame, len8Dlc) == offsetof(struct can_frame, len8_dlc));
+static_assert(offsetof(CanFrame, data) == offsetof(struct can_frame, data));
+static_assert(sizeof(CanFrame::data) == sizeof(can_frame::data));
+static_assert(sizeof(CanFrame::canId) == sizeof(can_frame::can_id));
+
+void * kernelFrame(const CanFrame & canFrame)
+{
+  return const_cast<CanFrame *>(&canFrame);
+}
+
+// the motors reply with standard data frames only
+bool isReply(const CanFrame & canFrame)
+{
+  return !(canFrame.canId & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG));
+}
+
+bool isError(const CanFrame & canFrame)
+{
+  return canFrame.canId & CAN_ERR_FLAG;
+}
+
+// the frame would fit once the adapter sent some, as opposed to a failure
+bool isBackpressure(int error)
+{
+  return error == ENOBUFS or error == EAGAIN or error == EWOULDBLOCK;
+}
+
+using kot_motor::transport::kernel_timestamp::ControlBuffer;
+using kot_motor::transport::kernel_timestamp::ClockOffset;
+using kot_motor::transport::kernel_timestamp::clockOffset;
+
+} // namespace
+
+SocketCanTransport::SocketCanTransport(const std::string& canName, bool calibrateAtOpen) 
   : sock()
   , ifname(canName)
+  , calibrateAtOpen(calibrateAtOpen)
 {}
 
 SocketCanTransport::~SocketCanTransport() {
@@ -19,8 +66,8 @@ SocketCanTransport::~SocketCanTransport() {
 
 SocketCanTransport::Status SocketCanTransport::open() {
   // creates an endpoint for communication
-  // returns a socket descriptor
-  int s = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+  // returns a socket descriptor, reading never blocks the caller
+  int s = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
   if (s == -1) {
     return Status::FAIL;
   }
@@ -47,12 +94,39 @@ SocketCanTransport::Status SocketCanTransport::open() {
 
   sock = s;
 
+  // Receive timestamps: SO_TIMESTAMPING first, then SO_TIMESTAMPNS,
+  // if neither is supported the frames are stamped on reading
+  int stampFlags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+  if (setsockopt(s, SOL_SOCKET, SO_TIMESTAMPING, &stampFlags, sizeof(stampFlags)) == -1) {
+    int enable = 1;
+    setsockopt(s, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+  }
+
+  if (applyFilters() != Status::SUCCESS) {
+    this->close();
+    return Status::FAIL;
+  }
+
+  // without a measurement the bus model is used, no reason to fail
+  if (calibrateAtOpen) {
+    calibrate();
+  }
+
   return Status::SUCCESS_INIT;
 }
 
 SocketCanTransport::Status SocketCanTransport::close() {
-  ::close(int(sock.value()));
+  if (!sock.has_value()) {
+    return Status::FAIL;
+  }
+  ::close(sock.value());
   sock.reset();
+
+  // the held frames would be outdated by a reopening
+  mailed.fill(false);
+  ordered.fill(false);
+  mailHead = mailN = 0;
+  urgentHead = urgentN = 0;
   return Status::SUCCESS;
 }
 
@@ -61,32 +135,459 @@ SocketCanTransport::Status SocketCanTransport::write(const CanFrame & canFrame)
     return Status::FAIL;
   }
 
-  struct can_frame frame;
-  frame.can_id = canFrame.canId;
-  frame.len = canFrame.size;
+  // the held frames are older, the new one can't overtake them
+  if (heldFrames() > 0 and flush() > 0) {
+    return hold(canFrame) ? Status::SUCCESS : Status::FAIL;
+  }
 
-  std::memcpy(frame.data, canFrame.data, canFrame.size);
+  int error = send(canFrame);
+  if (error == 0) {
+    return Status::SUCCESS;
+  } else if (isBackpressure(error) and hold(canFrame)) {
+    return Status::SUCCESS;
+  }
+  countWriteFailures(&canFrame, 1);
+  return Status::FAIL;
+}
 
-  int nbytes = ::write(sock.value(), &frame, sizeof(struct can_frame));
-  if (nbytes == -1) {
+SocketCanTransport::Status SocketCanTransport::writeUrgent(const CanFrame & canFrame) {
+  if (!sock.has_value()) {
     return Status::FAIL;
-  } else {
+  }
+
+  // the regular command still held for the motor is outdated now, a
+  // held mode frame is with the urgent ones and goes out first
+  if (canFrame.canId < mailed.size()) {
+    mailed[canFrame.canId] = false;
+  }
+
+  // skips the held regular commands, only the urgent ones go first
+  if (urgentN > 0 and flushUrgent() > 0) {
+    return holdUrgent(canFrame) ? Status::SUCCESS : Status::FAIL;
+  }
+
+  int error = send(canFrame);
+  if (error == 0) {
+    return Status::SUCCESS;
+  } else if (isBackpressure(error) and holdUrgent(canFrame)) {
     return Status::SUCCESS;
   }
+  countWriteFailures(&canFrame, 1);
+  return Status::FAIL;
 }
 
 std::optional<SocketCanTransport::CanFrame> SocketCanTransport::read() {
-  // TODO
-  if (sock.has_value()) {
-    return {};
+  CanFrame canFrame;
+  if (readBatch(&canFrame, 1) == 1) {
+    return canFrame;
   }
   return {};
 }
 
+size_t SocketCanTransport::writeBatch(const CanFrame * canFrames, size_t count) {
+  if (!sock.has_value()) {
+    return 0;
+  }
+
+  size_t sent = 0;
+  if (heldFrames() > 0 and flush() > 0) {
+    while (sent < count and hold(canFrames[sent])) {
+      sent++;
+    }
+    return sent;
+  }
+
+  std::array<struct iovec, BATCH_SIZE> iovs;
+  std::array<struct mmsghdr, BATCH_SIZE> msgs;
+
+  while (sent < count) {
+    size_t n = std::min(count - sent, BATCH_SIZE);
+    for (size_t i = 0; i < n; i++) {
+      iovs[i].iov_base = kernelFrame(canFrames[sent + i]);
+      iovs[i].iov_len = sizeof(struct can_frame);
+      msgs[i] = {};
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    // one syscall for the whole chunk instead of one per frame
+    int res = sendmmsg(sock.value(), msgs.data(), n, 0);
+    if (res == -1 and errno == EINTR) {
+      continue;
+    } else if (res == -1 and isBackpressure(errno)) {
+      // the rest waits in the mailboxes
+      while (sent < count and hold(canFrames[sent])) {
+        sent++;
+      }
+      break;
+    } else if (res == -1) {
+      countWriteFailures(canFrames + sent, count - sent);
+      break; // the bus is down
+    }
+
+    countSent(canFrames + sent, res);
+    sent += res;
+  }
+
+  return sent;
+}
+
+size_t SocketCanTransport::readBatch(CanFrame * canFrames, size_t count) {
+  if (!sock.has_value()) {
+    return 0;
+  }
+
+  if (heldFrames() > 0) {
+    flush();
+  }
+
+  std::array<struct iovec, BATCH_SIZE> iovs;
+  std::array<struct mmsghdr, BATCH_SIZE> msgs;
+  std::array<ControlBuffer, BATCH_SIZE> controls;
+
+  size_t received = 0;
+  while (received < count) {
+    size_t n = std::min(count - received, BATCH_SIZE);
+    for (size_t i = 0; i < n; i++) {
+      // received right into the caller's frames
+      iovs[i].iov_base = &canFrames[received + i];
+      iovs[i].iov_len = sizeof(struct can_frame);
+      msgs[i] = {};
+      msgs[i].msg_hdr.msg_iov = &iovs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+      msgs[i].msg_hdr.msg_control = controls[i].data;
+      msgs[i].msg_hdr.msg_controllen = sizeof(controls[i].data);
+    }
+
+    // the socket is non-blocking, so only the pending frames are taken
+    int res = recvmmsg(sock.value(), msgs.data(), n, 0, nullptr);
+    if (res == -1 and errno == EINTR) {
+      continue;
+    } else if (res <= 0) {
+      break;
+    }
+
+    // the kernel stamps with CLOCK_REALTIME, the frames carry the
+    // steady clock, so the offset between them is taken once per chunk
+    ClockOffset offset = clockOffset();
+
+    // the frames which are not replies leave holes to be closed
+    size_t kept = received;
+    for (int i = 0; i < res; i++) {
+      CanFrame & canFrame = canFrames[received + i];
+      if (msgs[i].msg_len != sizeof(struct can_frame)) {
+        continue;
+      } else if (isReply(canFrame)) {
+        canFrame.timestamp = kernel_timestamp::fromControl(msgs[i].msg_hdr, offset);
+        if (received + i != kept) {
+          canFrames[kept] = canFrame;
+        }
+        kept++;
+      } else if (isError(canFrame)) {
+        collectError(canFrame);
+      }
+    }
+    countReceived(kept - received);
+    received = kept;
+
+    if (size_t(res) < n) {
+      break;
+    }
+  }
+
+  return received;
+}
+
+bool SocketCanTransport::wait(std::chrono::microseconds timeout) {
+  if (!sock.has_value()) {
+    return false;
+  }
+
+  if (heldFrames() > 0) {
+    flush();
+  }
+
+  // ppoll keeps the sub-millisecond precision a 1 kHz loop needs
+  struct pollfd pfd = {sock.value(), POLLIN, 0};
+  auto sec = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+  struct timespec ts;
+  ts.tv_sec = sec.count();
+  ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - sec).count();
+
+  int ready = ppoll(&pfd, 1, &ts, nullptr);
+  return ready > 0 and (pfd.revents & POLLIN);
+}
+
 const std::string& SocketCanTransport::canInterfaceName() const {
   return ifname;
 }
 
+std::optional<int> SocketCanTransport::descriptor() const noexcept {
+  return sock;
+}
 
+/******************************** Backpressure ********************************/
 
+size_t SocketCanTransport::flush() {
+  if (!sock.has_value()) {
+    return heldFrames();
+  }
+  if (flushUrgent() == 0) {
+    flushMailboxes();
+  }
+  return heldFrames();
+}
 
+size_t SocketCanTransport::heldFrames() const noexcept {
+  return urgentN + mailN;
+}
+
+size_t SocketCanTransport::flushUrgent() noexcept {
+  while (urgentN > 0) {
+    int error = send(urgent[urgentHead]);
+    if (isBackpressure(error)) {
+      break;
+    } else if (error != 0) {
+      countWriteFailures(&urgent[urgentHead], 1);
+    }
+    // a frame refused for another reason is dropped, it would never pass
+    urgentHead = (urgentHead + 1) % urgent.size();
+    urgentN--;
+  }
+  return urgentN;
+}
+
+size_t SocketCanTransport::flushMailboxes() noexcept {
+  while (mailN > 0) {
+    uint8_t canId = mailOrder[mailHead];
+    // skipped if superseded by an urgent frame meanwhile
+    if (mailed[canId]) {
+      int error = send(mailboxes[canId]);
+      if (isBackpressure(error)) {
+        break;
+      } else if (error != 0) {
+        countWriteFailures(&mailboxes[canId], 1);
+      }
+      mailed[canId] = false;
+    }
+    ordered[canId] = false;
+    mailHead = (mailHead + 1) % mailOrder.size();
+    mailN--;
+  }
+  return mailN;
+}
+
+int SocketCanTransport::send(const CanFrame & canFrame) noexcept {
+  while (::write(sock.value(), kernelFrame(canFrame), sizeof(struct can_frame)) == -1) {
+    if (errno != EINTR) {
+      return errno;
+    }
+  }
+  countSent(&canFrame, 1);
+  return 0;
+}
+
+bool SocketCanTransport::hold(const CanFrame & canFrame) noexcept {
+  // only the commands, which carry the motor id, have a mailbox
+  if (canFrame.canId >= mailboxes.size()) {
+    return false;
+  }
+
+  // a mode frame replaces nothing and is replaced by nothing, it waits
+  // with the urgent frames behind the command it followed
+  uint8_t canId = canFrame.canId;
+  if (isModeFrame(canFrame)) {
+    size_t needed = mailed[canId] ? 2 : 1;
+    if (urgent.size() - urgentN < needed) {
+      return false;
+    }
+    if (mailed[canId]) {
+      urgent[(urgentHead + urgentN) % urgent.size()] = mailboxes[canId];
+      urgentN++;
+      mailed[canId] = false;
+    }
+    return holdUrgent(canFrame);
+  }
+
+  // a newer command keeps the place of the one it replaces
+  if (!ordered[canId]) {
+    mailOrder[(mailHead + mailN) % mailOrder.size()] = canId;
+    mailN++;
+    ordered[canId] = true;
+  }
+  mailboxes[canId] = canFrame;
+  mailed[canId] = true;
+  countBackpressure(canFrame);
+  return true;
+}
+
+bool SocketCanTransport::holdUrgent(const CanFrame & canFrame) noexcept {
+  if (urgentN == urgent.size()) {
+    return false;
+  }
+  urgent[(urgentHead + urgentN) % urgent.size()] = canFrame;
+  urgentN++;
+  countBackpressure(canFrame);
+  return true;
+}
+
+/****************************** Kernel filtering ******************************/
+
+void SocketCanTransport::attachMotor(uint8_t canId, uint8_t masterCanId) noexcept {
+  BasicTransport::attachMotor(canId, masterCanId);
+  if (masterUsers[masterCanId]++ == 0) {
+    applyFilters();
+  }
+}
+
+void SocketCanTransport::detachMotor(uint8_t canId, uint8_t masterCanId) noexcept {
+  BasicTransport::detachMotor(canId, masterCanId);
+  if (masterUsers[masterCanId] > 0 and --masterUsers[masterCanId] == 0) {
+    applyFilters();
+  }
+}
+
+SocketCanTransport::Status SocketCanTransport::errorFilter(can_err_mask_t errMask) {
+  this->errMask = errMask & CAN_ERR_MASK;
+  return applyFilters();
+}
+
+can_err_mask_t SocketCanTransport::takeBusErrors() noexcept {
+  can_err_mask_t errors = busErrors;
+  busErrors = 0;
+  return errors;
+}
+
+SocketCanTransport::Status SocketCanTransport::applyFilters() noexcept {
+  if (!sock.has_value()) {
+    return Status::SUCCESS; // applied on open
+  }
+
+  // The MIT firmware replies to the master id and puts its own id into
+  // the first data byte, which the kernel can't match on, so a filter
+  // per master id is installed and the motor id is checked in route().
+  std::array<struct can_filter, 256> filters;
+  size_t filtersN = 0;
+  for (size_t masterId = 0; masterId < masterUsers.size(); masterId++) {
+    if (masterUsers[masterId] > 0) {
+      filters[filtersN].can_id = masterId;
+      filters[filtersN].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+      filtersN++;
+    }
+  }
+
+  // nothing attached, the kernel default of receiving everything is kept
+  if (filtersN == 0) {
+    filters[0].can_id = 0;
+    filters[0].can_mask = 0;
+    filtersN = 1;
+  }
+
+  if (setsockopt(sock.value(), SOL_CAN_RAW, CAN_RAW_FILTER, filters.data(), filtersN * sizeof(struct can_filter)) == -1) {
+    return Status::FAIL;
+  }
+
+  if (setsockopt(sock.value(), SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &errMask, sizeof(errMask)) == -1) {
+    return Status::FAIL;
+  }
+
+  return Status::SUCCESS;
+}
+
+void SocketCanTransport::collectError(const CanFrame & canFrame) noexcept {
+  busErrors |= canFrame.canId & CAN_ERR_MASK;
+  countErrorFrame();
+}
+
+/******************************** Calibration ********************************/
+
+SocketCanTransport::Status SocketCanTransport::calibrate(size_t samples, uint32_t probeCanId) {
+  // a motor id would command the motor
+  if (!sock.has_value() or samples == 0 or probeCanId <= 0xFF or probeCanId > CAN_SFF_MASK) {
+    return Status::FAIL;
+  }
+
+  // the probes would delay the commands of the driven motors
+  bool motorsAttached = std::any_of(masterUsers.begin(), masterUsers.end(), [](uint16_t users) {
+    return users > 0;
+  });
+  if (motorsAttached) {
+    return Status::FAIL;
+  }
+
+  // a socket of its own, the probes neither pass the mailboxes
+  // nor reach the reply table
+  int probe = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
+  if (probe == -1) {
+    return Status::FAIL;
+  }
+
+  struct sockaddr_can addr = {};
+  addr.can_family = AF_CAN;
+  addr.can_ifindex = if_nametoindex(ifname.c_str());
+  int enable = 1;
+  struct can_filter filter = {probeCanId, CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG};
+  if (addr.can_ifindex == 0 or
+      bind(probe, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1 or
+      setsockopt(probe, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &enable, sizeof(enable)) == -1 or
+      setsockopt(probe, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter)) == -1)
+  {
+    ::close(probe);
+    return Status::FAIL;
+  }
+
+  struct can_frame frame = {};
+  frame.can_id = probeCanId;
+  frame.len = BusLoad::COMMAND_SIZE;
+
+  std::vector<CanFrame::Clock::duration> costs;
+  costs.reserve(samples);
+  while (costs.size() < samples) {
+    auto start = CanFrame::Clock::now();
+    auto deadline = start + PROBE_TIMEOUT;
+    if (::write(probe, &frame, sizeof(frame)) != sizeof(frame)) {
+      break;
+    }
+
+    bool echoed = false;
+    while (!echoed) {
+      auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - CanFrame::Clock::now());
+      if (left.count() <= 0) {
+        break;
+      }
+      struct pollfd pfd = {probe, POLLIN, 0};
+      struct timespec timeout = {time_t(left.count() / 1000000000), long(left.count() % 1000000000)};
+      if (ppoll(&pfd, 1, &timeout, nullptr) <= 0) {
+        break;
+      }
+      struct can_frame echo;
+      echoed = ::read(probe, &echo, sizeof(echo)) == sizeof(echo) and echo.can_id == probeCanId;
+    }
+    if (!echoed) {
+      break; // not acknowledged, or the tx queue is stuck
+    }
+    costs.push_back(CanFrame::Clock::now() - start);
+  }
+  ::close(probe);
+
+  if (costs.size() < samples) {
+    return Status::FAIL;
+  }
+
+  auto median = costs.begin() + costs.size() / 2;
+  std::nth_element(costs.begin(), median, costs.end());
+  measuredSendCost = std::chrono::duration_cast<std::chrono::nanoseconds>(*median);
+  return Status::SUCCESS;
+}
+
+std::optional<std::chrono::nanoseconds> SocketCanTransport::sendCost() const noexcept {
+  return measuredSendCost;
+}
+
+std::chrono::nanoseconds SocketCanTransport::frameTime() const noexcept {
+  std::chrono::nanoseconds modelled = BasicTransport::frameTime();
+  if (!measuredSendCost.has_value()) {
+    return modelled;
+  }
+  return std::max(modelled, measuredSendCost.value() + busLoad().replyTime());
+}
@@ -1,6 +1,7 @@
 #ifndef SOCKETCAN_TRANSPORT_HPP
 #define SOCKETCAN_TRANSPORT_HPP
 
+#include <array>
 #include <string>
 #include <cstring>
 #include <cstdio>
@@ -12,30 +13,118 @@
 #include <sys/socket.h>
 #include <linux/can.h>
 #include <linux/can/raw.h>
+#include <linux/can/error.h>
 #include "basic_transport.hpp"
 
 namespace kot_motor::transport {
 
 class SocketCanTransport : public BasicTransport {
 public:
-  SocketCanTransport(const std::string& canName);
+  // max number of frames passed to the kernel by one sendmmsg/recvmmsg
+  static constexpr size_t BATCH_SIZE = 64;
+  // urgent frames held while the tx queue is full
+  static constexpr size_t URGENT_SIZE = 16;
+
+  // default id of the calibration frames, outside of the 8 bit motor ids
+  static constexpr uint32_t PROBE_CAN_ID = 0x7FF;
+  static constexpr size_t CALIBRATION_SAMPLES = 32;
+  static constexpr std::chrono::milliseconds PROBE_TIMEOUT{100};
+
+  // error classes worth to know about while driving the motors
+  static constexpr can_err_mask_t BUS_ERRORS =
+    CAN_ERR_TX_TIMEOUT | CAN_ERR_CRTL | CAN_ERR_PROT | CAN_ERR_ACK |
+    CAN_ERR_BUSOFF | CAN_ERR_BUSERROR | CAN_ERR_RESTARTED;
+
+public:
+  // With calibrateAtOpen the send cost is measured by every open()
+  SocketCanTransport(const std::string& canName, bool calibrateAtOpen = false);
   ~SocketCanTransport();
 
   Status open();
   Status close();
+
+  // When the tx queue is full (ENOBUFS) a command is held in the mailbox
+  // of its motor, replacing the older unsent one, and counts as written.
+  // The held frames go out first once the queue drains, so a command
+  // never waits behind outdated ones. A mode frame is never replaced, it
+  // is held with the urgent frames, behind the command it followed.
   Status write(const CanFrame & canFrame) override;
+  Status writeUrgent(const CanFrame & canFrame) override;
   std::optional<CanFrame> read() override;
+  size_t writeBatch(const CanFrame * canFrames, size_t count) override;
+  size_t readBatch(CanFrame * canFrames, size_t count) override;
+  bool wait(std::chrono::microseconds timeout) override;
   const std::string& canInterfaceName() const;
+  std::optional<int> descriptor() const noexcept override;
+
+  // Passes the held frames to the kernel, the urgent ones first,
+  // returns the number of frames still held. Done by every write,
+  // read and wait as well.
+  size_t flush();
+  size_t heldFrames() const noexcept;
+
+  // Kernel side filtering, only the replies to the masters of the
+  // attached motors are passed to userspace
+  void attachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+  void detachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+
+  // Measures the cost of sending a frame on this adapter: the time from
+  // the write of a probe frame to its echo by the driver, the median of
+  // `samples` ones. The drivers of real adapters (gs_usb, mcp251x) echo
+  // on tx completion, so the wire time and their own latency are both
+  // measured, vcan echoes right away and leaves the bus model in charge.
+  // Needs another node to acknowledge the probes.
+  // Puts `samples` data frames with the `probeCanId` on the live bus,
+  // where every node sees them and the traffic waits behind them: the id
+  // has to be a standard one past the 8 bit motor ids which nobody
+  // listens to. Refused (FAIL) while motors are attached, it runs before
+  // they are driven, as the calibration at open does. The previous
+  // measurement is kept on failure.
+  Status calibrate(size_t samples = CALIBRATION_SAMPLES, uint32_t probeCanId = PROBE_CAN_ID);
+  std::optional<std::chrono::nanoseconds> sendCost() const noexcept;
+
+  // The measured send cost and the reply, the bus model as the lower bound
+  std::chrono::nanoseconds frameTime() const noexcept override;
+
+  // Error frames of the given classes are received, 0 disables them
+  Status errorFilter(can_err_mask_t errMask);
+  // Error classes received since the last call
+  can_err_mask_t takeBusErrors() noexcept;
+  // Accounts an error frame received by a backend draining the socket itself
+  void collectError(const CanFrame & canFrame) noexcept;
 
 private:
-  std::optional<int> sock; // file descriptor
-  const std::string ifname;
-};
+  Status applyFilters() noexcept;
 
-} // namespace kot_motor::transport
+  size_t flushUrgent() noexcept;
+  size_t flushMailboxes() noexcept;
+  int send(const CanFrame & canFrame) noexcept;
+  bool hold(const CanFrame & canFrame) noexcept;
+  bool holdUrgent(const CanFrame & canFrame) noexcept;
 
-#endif // SOCKETCAN_TRANSPORT_HPP
+private:
+  std::optional<int> sock; // file descriptor, opened as non-blocking
+  const std::string ifname;
+  const bool calibrateAtOpen;
+  std::optional<std::chrono::nanoseconds> measuredSendCost;
 
+  std::array<uint16_t, 256> masterUsers = {}; // attached motors per master id
+  can_err_mask_t errMask = 0;
+  can_err_mask_t busErrors = 0;
 
+  // latest unsent command per motor id, sent in the order of arrival
+  std::array<CanFrame, 256> mailboxes;
+  std::array<bool, 256> mailed = {};  // holds a frame to send
+  std::array<bool, 256> ordered = {}; // has a place in the order
+  std::array<uint8_t, 256> mailOrder;
+  size_t mailHead = 0;
+  size_t mailN = 0;
 
+  std::array<CanFrame, URGENT_SIZE> urgent;
+  size_t urgentHead = 0;
+  size_t urgentN = 0;
+};
 
+} // namespace kot_motor::transport
+
+#endif // SOCKETCAN_TRANSPORT_HPP
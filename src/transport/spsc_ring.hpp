@@ -0,0 +1,69 @@
+#ifndef SPSC_RING_HPP
+#define SPSC_RING_HPP
+
+#include <stddef.h>
+#include <array>
+#include <atomic>
+#include <optional>
+
+namespace kot_motor::transport {
+
+// Wait-free single-producer/single-consumer ring buffer.
+// push() must be called from one thread only and pop() from one other
+// thread only, neither of them ever blocks or allocates.
+template <typename T, size_t Size>
+class SpscRing {
+  static_assert(Size >= 2 and (Size & (Size - 1)) == 0, "Size must be a power of 2");
+
+public:
+  bool push(const T & value) noexcept
+  {
+    size_t tail = this->tail.load(std::memory_order_relaxed);
+    if (tail - headCache == Size) {
+      headCache = head.load(std::memory_order_acquire);
+      if (tail - headCache == Size) {
+        return false; // full
+      }
+    }
+    items[tail & (Size - 1)] = value;
+    this->tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  std::optional<T> pop() noexcept
+  {
+    size_t head = this->head.load(std::memory_order_relaxed);
+    if (head == tailCache) {
+      tailCache = tail.load(std::memory_order_acquire);
+      if (head == tailCache) {
+        return {}; // empty
+      }
+    }
+    T value = items[head & (Size - 1)];
+    this->head.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  // approximate when called concurrently with push() or pop()
+  size_t size() const noexcept
+  {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+
+  static constexpr size_t capacity() noexcept
+  {
+    return Size;
+  }
+
+private:
+  // producer and consumer indices live on separate cache lines
+  alignas(64) std::atomic<size_t> head{0};
+  size_t tailCache = 0; // consumer's copy of tail
+  alignas(64) std::atomic<size_t> tail{0};
+  size_t headCache = 0; // producer's copy of head
+  alignas(64) std::array<T, Size> items;
+};
+
+} // namespace kot_motor::transport
+
+#endif // SPSC_RING_HPP
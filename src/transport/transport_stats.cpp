@@ -0,0 +1,196 @@
+#include <algorithm>
+#include "transport_stats.hpp"
+
+using kot_motor::transport::LatencyHistogram;
+using kot_motor::transport::TransportStats;
+
+namespace {
+
+// single writer per side, a plain load and store is enough and avoids a
+// locked add
+void increment(std::atomic<uint64_t> & value, uint64_t n) noexcept
+{
+  value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+} // namespace
+
+/***************************** LatencyHistogram *****************************/
+
+size_t LatencyHistogram::bucketOf(uint64_t ns) noexcept
+{
+  if (ns < SUB_BUCKETS) {
+    return ns;
+  }
+
+  unsigned msb = 63 - __builtin_clzll(ns);
+  if (msb >= MAX_BITS) {
+    return BUCKETS - 1;
+  }
+
+  // the SUB_BITS bits below the leading one select the linear bucket
+  unsigned shift = msb - SUB_BITS;
+  return (shift + 1) * SUB_BUCKETS + ((ns >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::bucketUpperEdge(size_t bucket) noexcept
+{
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+
+  unsigned shift = bucket / SUB_BUCKETS - 1;
+  uint64_t sub = bucket % SUB_BUCKETS + SUB_BUCKETS;
+  return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds value) noexcept
+{
+  uint64_t ns = value.count() > 0 ? value.count() : 0;
+  increment(counts[bucketOf(ns)], 1);
+  increment(count, 1);
+  increment(sumNs, ns);
+  if (ns > maxNs.load(std::memory_order_relaxed)) {
+    maxNs.store(ns, std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogram::read(Snapshot & snapshot) const noexcept
+{
+  for (size_t i = 0; i < BUCKETS; i++) {
+    snapshot.counts[i] = counts[i].load(std::memory_order_relaxed);
+  }
+  snapshot.count = count.load(std::memory_order_relaxed);
+  snapshot.sumNs = sumNs.load(std::memory_order_relaxed);
+  snapshot.maxNs = maxNs.load(std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds LatencyHistogram::Snapshot::mean() const noexcept
+{
+  return std::chrono::nanoseconds(count > 0 ? sumNs / count : 0);
+}
+
+std::chrono::nanoseconds LatencyHistogram::Snapshot::max() const noexcept
+{
+  return std::chrono::nanoseconds(maxNs);
+}
+
+std::chrono::nanoseconds LatencyHistogram::Snapshot::percentile(double share) const noexcept
+{
+  if (count == 0) {
+    return std::chrono::nanoseconds(0);
+  }
+
+  uint64_t rank = share >= 1.0 ? count : uint64_t(share * count) + 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKETS; i++) {
+    seen += counts[i];
+    if (seen >= rank) {
+      // the exact maximum is tighter than the edge of its bucket
+      return std::chrono::nanoseconds(std::min(bucketUpperEdge(i), maxNs));
+    }
+  }
+  return std::chrono::nanoseconds(maxNs);
+}
+
+/****************************** TransportStats ******************************/
+
+void TransportStats::countSent(uint64_t n) noexcept
+{
+  add(sendSequence, sent, n);
+}
+
+void TransportStats::countReceived(uint64_t n) noexcept
+{
+  add(receiveSequence, received, n);
+}
+
+void TransportStats::countWriteFailures(uint64_t n) noexcept
+{
+  add(sendSequence, writeFailures, n);
+}
+
+void TransportStats::countBackpressure() noexcept
+{
+  add(sendSequence, backpressure, 1);
+}
+
+void TransportStats::countDroppedReply() noexcept
+{
+  add(receiveSequence, droppedReplies, 1);
+}
+
+void TransportStats::countStaleReply() noexcept
+{
+  add(receiveSequence, staleReplies, 1);
+}
+
+void TransportStats::countErrorFrame() noexcept
+{
+  add(receiveSequence, errorFrames, 1);
+}
+
+void TransportStats::recordRoundTrip(std::chrono::nanoseconds value) noexcept
+{
+  beginUpdate(receiveSequence);
+  roundTrip.record(value);
+  endUpdate(receiveSequence);
+}
+
+void TransportStats::recordReplyGap(std::chrono::nanoseconds value) noexcept
+{
+  beginUpdate(receiveSequence);
+  replyGap.record(value);
+  endUpdate(receiveSequence);
+}
+
+TransportStats::Snapshot TransportStats::snapshot() const noexcept
+{
+  Snapshot snapshot;
+  uint32_t before = 0;
+  uint32_t after = 0;
+  do {
+    before = sendSequence.load(std::memory_order_acquire);
+
+    snapshot.counters.sent = sent.load(std::memory_order_relaxed);
+    snapshot.counters.writeFailures = writeFailures.load(std::memory_order_relaxed);
+    snapshot.counters.backpressure = backpressure.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = sendSequence.load(std::memory_order_relaxed);
+  } while ((before & 1) or before != after);
+
+  do {
+    before = receiveSequence.load(std::memory_order_acquire);
+
+    snapshot.counters.received = received.load(std::memory_order_relaxed);
+    snapshot.counters.droppedReplies = droppedReplies.load(std::memory_order_relaxed);
+    snapshot.counters.staleReplies = staleReplies.load(std::memory_order_relaxed);
+    snapshot.counters.errorFrames = errorFrames.load(std::memory_order_relaxed);
+    roundTrip.read(snapshot.roundTrip);
+    replyGap.read(snapshot.replyGap);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = receiveSequence.load(std::memory_order_relaxed);
+  } while ((before & 1) or before != after);
+
+  return snapshot;
+}
+
+void TransportStats::add(std::atomic<uint32_t> & sequence, std::atomic<uint64_t> & counter, uint64_t n) noexcept
+{
+  beginUpdate(sequence);
+  increment(counter, n);
+  endUpdate(sequence);
+}
+
+void TransportStats::beginUpdate(std::atomic<uint32_t> & sequence) noexcept
+{
+  sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+void TransportStats::endUpdate(std::atomic<uint32_t> & sequence) noexcept
+{
+  sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,111 @@
+#ifndef TRANSPORT_STATS_HPP
+#define TRANSPORT_STATS_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+
+namespace kot_motor::transport {
+
+// Log-linear histogram of durations in the spirit of HdrHistogram: each
+// power of two of nanoseconds is split into 16 linear buckets, so a value
+// is known within 1/16 of itself, up to about a second. Longer ones fall
+// into the last bucket.
+class LatencyHistogram {
+public:
+  static constexpr unsigned SUB_BITS = 4;
+  static constexpr unsigned SUB_BUCKETS = 1u << SUB_BITS;
+  static constexpr unsigned MAX_BITS = 30;
+  static constexpr size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+  struct Snapshot {
+    std::array<uint64_t, BUCKETS> counts = {};
+    uint64_t count = 0;
+    uint64_t sumNs = 0;
+    uint64_t maxNs = 0;
+
+    std::chrono::nanoseconds mean() const noexcept;
+    std::chrono::nanoseconds max() const noexcept;
+    // the upper edge of the bucket holding the given share of the values
+    std::chrono::nanoseconds percentile(double share) const noexcept;
+  };
+
+public:
+  void record(std::chrono::nanoseconds value) noexcept;
+  void read(Snapshot & snapshot) const noexcept;
+
+  static size_t bucketOf(uint64_t ns) noexcept;
+  static uint64_t bucketUpperEdge(size_t bucket) noexcept;
+
+private:
+  std::array<std::atomic<uint64_t>, BUCKETS> counts = {};
+  std::atomic<uint64_t> count{0};
+  std::atomic<uint64_t> sumNs{0};
+  std::atomic<uint64_t> maxNs{0};
+};
+
+// Counters and latencies of a transport, the same figures are kept for
+// every attached motor. The send side (sent, write failures,
+// backpressure) and the receive side (the rest) are each updated with
+// relaxed atomics by a single thread, which may differ, as the command
+// and the feedback threads of IoEngine do. A sequence counter per side
+// lets any other thread take a consistent snapshot without blocking them.
+class TransportStats {
+public:
+  struct Counters {
+    uint64_t sent = 0;           // frames passed to the bus
+    uint64_t received = 0;       // frames taken from the bus
+    uint64_t writeFailures = 0;  // frames the bus refused
+    uint64_t backpressure = 0;   // frames held because the tx queue was full
+    uint64_t droppedReplies = 0; // replies overwritten before being taken
+    uint64_t staleReplies = 0;   // replies older than the latest command
+    uint64_t errorFrames = 0;    // bus error frames, per transport only
+  };
+
+  struct Snapshot {
+    Counters counters;
+    LatencyHistogram::Snapshot roundTrip; // command sent to its reply received
+    LatencyHistogram::Snapshot replyGap;  // between consecutive replies
+  };
+
+public:
+  void countSent(uint64_t n) noexcept;
+  void countReceived(uint64_t n) noexcept;
+  void countWriteFailures(uint64_t n) noexcept;
+  void countBackpressure() noexcept;
+  void countDroppedReply() noexcept;
+  void countStaleReply() noexcept;
+  void countErrorFrame() noexcept;
+  void recordRoundTrip(std::chrono::nanoseconds value) noexcept;
+  void recordReplyGap(std::chrono::nanoseconds value) noexcept;
+
+  // Retries while an update is in progress, never blocks the writer
+  Snapshot snapshot() const noexcept;
+
+private:
+  static void add(std::atomic<uint32_t> & sequence, std::atomic<uint64_t> & counter, uint64_t n) noexcept;
+  static void beginUpdate(std::atomic<uint32_t> & sequence) noexcept;
+  static void endUpdate(std::atomic<uint32_t> & sequence) noexcept;
+
+private:
+  // odd while an update of the side is in progress
+  std::atomic<uint32_t> sendSequence{0};
+  std::atomic<uint32_t> receiveSequence{0};
+
+  std::atomic<uint64_t> sent{0};
+  std::atomic<uint64_t> received{0};
+  std::atomic<uint64_t> writeFailures{0};
+  std::atomic<uint64_t> backpressure{0};
+  std::atomic<uint64_t> droppedReplies{0};
+  std::atomic<uint64_t> staleReplies{0};
+  std::atomic<uint64_t> errorFrames{0};
+
+  LatencyHistogram roundTrip;
+  LatencyHistogram replyGap;
+};
+
+} // namespace kot_motor::transport
+
+#endif // TRANSPORT_STATS_HPP
@@ -0,0 +1,659 @@
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "uring_bus_group.hpp"
+
+using kot_motor::transport::UringBusGroup;
+namespace kernel_timestamp = kot_motor::transport::kernel_timestamp;
+
+namespace {
+
+using CanFrame = UringBusGroup::CanFrame;
+
+// the completions of the receives carry the bus index under this bit,
+// the ones of the provided buffers their first and count under the
+// other, the ones of the sends carry the tx slot
+constexpr uint64_t RECEIVE_TAG = uint64_t(1) << 63;
+constexpr uint64_t PROVIDE_TAG = uint64_t(1) << 62;
+static_assert(UringBusGroup::RX_BUFFERS <= 0xFFFF);
+constexpr uint16_t BUFFER_GROUP = 0;
+
+// the motors reply with standard data frames only
+bool isReply(const CanFrame & canFrame)
+{
+  return !(canFrame.canId & (CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_ERR_FLAG));
+}
+
+bool isError(const CanFrame & canFrame)
+{
+  return canFrame.canId & CAN_ERR_FLAG;
+}
+
+// there is no glibc wrapper, liburing isn't required for these two calls
+int uringSetup(unsigned entries, struct io_uring_params * params)
+{
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, const void * arg, size_t argSize)
+{
+  return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+} // namespace
+
+UringBusGroup::UringBusGroup(const std::vector<std::string> & canNames)
+  : rxBuffers(std::make_unique<RxBuffer[]>(RX_BUFFERS))
+  , txSlots(std::make_unique<CanFrame[]>(QUEUE_DEPTH))
+{
+  buses.reserve(canNames.size());
+  for (size_t i = 0; i < canNames.size(); i++) {
+    buses.push_back(std::make_unique<Bus>(*this, i, canNames[i]));
+  }
+
+  // no name is received, the control messages carry the timestamps
+  rxMsg.msg_namelen = 0;
+  rxMsg.msg_controllen = sizeof(kernel_timestamp::ControlBuffer);
+}
+
+UringBusGroup::~UringBusGroup()
+{
+  if (ringFd != -1) {
+    close();
+  }
+}
+
+UringBusGroup::Status UringBusGroup::open()
+{
+  if (setupRing() != Status::SUCCESS) {
+    return Status::FAIL;
+  }
+
+  for (auto && bus : buses) {
+    if (bus->socket.open() != Status::SUCCESS_INIT) {
+      close();
+      return Status::FAIL;
+    }
+    bus->fd = bus->socket.descriptor().value();
+    queueReceive(*bus);
+  }
+
+  if (submit() < 0) {
+    close();
+    return Status::FAIL;
+  }
+  return Status::SUCCESS_INIT;
+}
+
+UringBusGroup::Status UringBusGroup::close()
+{
+  // closing the ring cancels the receives still armed
+  teardownRing();
+
+  for (auto && bus : buses) {
+    if (bus->socket.descriptor().has_value()) {
+      bus->socket.close();
+    }
+    bus->fd = -1;
+    bus->deferred = false;
+    bus->receiving = false;
+    bus->beginAwaiting();
+    bus->receivedHead = 0;
+    bus->receivedN = 0;
+  }
+  return Status::SUCCESS;
+}
+
+size_t UringBusGroup::size() const noexcept
+{
+  return buses.size();
+}
+
+kot_motor::transport::BasicTransport & UringBusGroup::bus(size_t i)
+{
+  return *buses.at(i);
+}
+
+kot_motor::transport::SocketCanTransport & UringBusGroup::socket(size_t i)
+{
+  return buses.at(i)->socket;
+}
+
+uint64_t UringBusGroup::sendFailures() const noexcept
+{
+  return failures;
+}
+
+uint64_t UringBusGroup::droppedFrames() const noexcept
+{
+  return dropped;
+}
+
+/*********************************** Cycle ***********************************/
+
+void UringBusGroup::beginCycle() noexcept
+{
+  for (auto && bus : buses) {
+    bus->deferred = true;
+    bus->beginAwaiting();
+  }
+}
+
+UringBusGroup::Status UringBusGroup::send()
+{
+  // the sends queued for all the buses, submitted at once
+  Status status = submit() < 0 ? Status::FAIL : Status::SUCCESS;
+  for (auto && bus : buses) {
+    bus->deferred = false;
+  }
+  return status;
+}
+
+UringBusGroup::Status UringBusGroup::collect(std::chrono::microseconds timeout)
+{
+  auto deadline = CanFrame::Clock::now() + timeout;
+
+  while (true) {
+    bool pending = false;
+    for (auto && bus : buses) {
+      if (bus->awaitedReplies() == 0) {
+        continue;
+      }
+      if (bus->receive() > 0) {
+        bus->collectAnswers();
+      }
+      pending = pending or bus->awaitedReplies() > 0;
+    }
+
+    if (!pending) {
+      return Status::SUCCESS;
+    } else if (CanFrame::Clock::now() >= deadline) {
+      return Status::FAIL;
+    }
+
+    // a single wait over all the sockets
+    waitCompletions(deadline);
+  }
+}
+
+UringBusGroup::Status UringBusGroup::cycle(std::chrono::microseconds timeout)
+{
+  Status sendStatus = send();
+  Status collectStatus = collect(timeout);
+  return sendStatus == Status::SUCCESS and collectStatus == Status::SUCCESS
+    ? Status::SUCCESS
+    : Status::FAIL;
+}
+
+/*********************************** Ring ************************************/
+
+UringBusGroup::Status UringBusGroup::setupRing()
+{
+  if (ringFd != -1) {
+    return Status::FAIL;
+  }
+
+  // the completion queue is made roomy, a multishot receive posts
+  // one completion per frame
+  struct io_uring_params params = {};
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = 4 * QUEUE_DEPTH;
+  ringFd = uringSetup(QUEUE_DEPTH, &params);
+  if (ringFd < 0) {
+    ringFd = -1;
+    return Status::FAIL;
+  }
+
+  if (!(params.features & IORING_FEAT_SINGLE_MMAP) or !(params.features & IORING_FEAT_EXT_ARG)) {
+    teardownRing();
+    return Status::FAIL;
+  }
+
+  // both queues share one mapping
+  size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  ringsSize = std::max(sqSize, cqSize);
+  rings = mmap(nullptr, ringsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+  if (rings == MAP_FAILED) {
+    rings = nullptr;
+    teardownRing();
+    return Status::FAIL;
+  }
+
+  sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+  void * sqesMem = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+  if (sqesMem == MAP_FAILED) {
+    teardownRing();
+    return Status::FAIL;
+  }
+  sqes = static_cast<struct io_uring_sqe *>(sqesMem);
+
+  char * base = static_cast<char *>(rings);
+  sqHead = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+  sqTail = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+  sqArray = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+  sqMask = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+  sqEntries = params.sq_entries;
+  cqHead = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+  cqTail = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+  cqes = reinterpret_cast<struct io_uring_cqe *>(base + params.cq_off.cqes);
+  cqMask = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+  toSubmit = 0;
+
+  // all the receive buffers are handed over with the first submission
+  recycled.set();
+  recycledN = RX_BUFFERS;
+  provideRecycled();
+
+  for (uint16_t slot = 0; slot < QUEUE_DEPTH; slot++) {
+    freeSlots[slot] = slot;
+  }
+  freeSlotsN = QUEUE_DEPTH;
+
+  return Status::SUCCESS;
+}
+
+void UringBusGroup::teardownRing() noexcept
+{
+  if (ringFd != -1) {
+    ::close(ringFd);
+    ringFd = -1;
+  }
+  if (sqes != nullptr) {
+    munmap(sqes, sqesSize);
+    sqes = nullptr;
+  }
+  if (rings != nullptr) {
+    munmap(rings, ringsSize);
+    rings = nullptr;
+  }
+  toSubmit = 0;
+  recycled.reset();
+  recycledN = 0;
+  freeSlotsN = 0;
+}
+
+struct io_uring_sqe * UringBusGroup::nextSqe() noexcept
+{
+  if (ringFd == -1) {
+    return nullptr;
+  }
+
+  unsigned tail = *sqTail;
+  if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == sqEntries) {
+    if (submit() <= 0) {
+      return nullptr;
+    }
+  }
+
+  // the kernel reads the queue only inside io_uring_enter made by this
+  // thread, so the entry can be published before it's filled
+  unsigned index = tail & sqMask;
+  sqArray[index] = index;
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+  toSubmit++;
+
+  struct io_uring_sqe * sqe = &sqes[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+bool UringBusGroup::queueSend(const Bus & bus, const CanFrame & canFrame) noexcept
+{
+  if (freeSlotsN == 0) {
+    // the sends to sockets mostly complete within the submission
+    submit();
+    reap();
+    if (freeSlotsN == 0) {
+      return false;
+    }
+  }
+
+  uint16_t slot = freeSlots[freeSlotsN - 1];
+  struct io_uring_sqe * sqe = nextSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  freeSlotsN--;
+
+  txSlots[slot] = canFrame;
+  sqe->opcode = IORING_OP_SEND;
+  sqe->fd = bus.fd;
+  sqe->addr = reinterpret_cast<uint64_t>(&txSlots[slot]);
+  sqe->len = sizeof(struct can_frame);
+  sqe->user_data = slot;
+  return true;
+}
+
+void UringBusGroup::supersede(const Bus & bus, uint32_t canId) noexcept
+{
+  // the sends not submitted yet are turned into no-ops,
+  // their completions free the slots as usual. The mode frames stay,
+  // queued ahead of the frame superseding the commands.
+  unsigned tail = *sqTail;
+  for (unsigned i = tail - toSubmit; i != tail; i++) {
+    struct io_uring_sqe & sqe = sqes[i & sqMask];
+    if (sqe.opcode == IORING_OP_SEND and sqe.fd == bus.fd and txSlots[sqe.user_data].canId == canId and
+        !isModeFrame(txSlots[sqe.user_data])) {
+      sqe.opcode = IORING_OP_NOP;
+    }
+  }
+}
+
+bool UringBusGroup::queueReceive(Bus & bus) noexcept
+{
+  struct io_uring_sqe * sqe = nextSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+
+  // stays armed, one completion per frame into a provided buffer
+  sqe->opcode = IORING_OP_RECVMSG;
+  sqe->fd = bus.fd;
+  sqe->addr = reinterpret_cast<uint64_t>(&rxMsg);
+  sqe->len = 1;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BUFFER_GROUP;
+  sqe->user_data = RECEIVE_TAG | bus.index;
+  bus.receiving = true;
+  return true;
+}
+
+int UringBusGroup::submit() noexcept
+{
+  if (toSubmit == 0) {
+    return 0;
+  }
+
+  int res = uringEnter(ringFd, toSubmit, 0, 0, nullptr, 0);
+  if (res < 0) {
+    return -1;
+  }
+  toSubmit -= std::min(unsigned(res), toSubmit);
+  return res;
+}
+
+void UringBusGroup::waitCompletions(CanFrame::Clock::time_point deadline) noexcept
+{
+  auto remaining = deadline - CanFrame::Clock::now();
+  if (remaining <= CanFrame::Clock::duration::zero() or ringFd == -1) {
+    return;
+  }
+
+  auto sec = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+  struct __kernel_timespec ts;
+  ts.tv_sec = sec.count();
+  ts.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - sec).count();
+
+  struct io_uring_getevents_arg arg = {};
+  arg.ts = reinterpret_cast<uint64_t>(&ts);
+
+  // whatever is queued is submitted by the same call
+  int res = uringEnter(ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+  if (res > 0) {
+    toSubmit -= std::min(unsigned(res), toSubmit);
+  }
+}
+
+void UringBusGroup::reap() noexcept
+{
+  if (ringFd == -1) {
+    return;
+  }
+
+  unsigned head = *cqHead;
+  unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+  if (head == tail) {
+    return;
+  }
+
+  // taken once for all the frames reaped together
+  kernel_timestamp::ClockOffset offset = kernel_timestamp::clockOffset();
+
+  for (; head != tail; head++) {
+    const struct io_uring_cqe & cqe = cqes[head & cqMask];
+    if (cqe.user_data & RECEIVE_TAG) {
+      onReceive(*buses[cqe.user_data & ~RECEIVE_TAG], cqe, offset);
+    } else if (cqe.user_data & PROVIDE_TAG) {
+      // posted on failure only, the run is provided again below
+      size_t first = (cqe.user_data >> 16) & 0xFFFF;
+      size_t n = cqe.user_data & 0xFFFF;
+      for (size_t k = first; k < first + n; k++) {
+        recycle(uint16_t(k));
+      }
+    } else {
+      if (cqe.res < 0) {
+        failures++;
+      }
+      freeSlots[freeSlotsN++] = uint16_t(cqe.user_data);
+    }
+  }
+  __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+  // the recycled and the failed buffers go with the next submission
+  provideRecycled();
+
+  // the kernel ends a multishot receive e.g. when it ran out of buffers
+  bool rearmed = false;
+  for (auto && bus : buses) {
+    if (bus->fd != -1 and !bus->receiving) {
+      rearmed = queueReceive(*bus) or rearmed;
+    }
+  }
+  if (rearmed) {
+    submit();
+  }
+}
+
+void UringBusGroup::onReceive(Bus & bus, const struct io_uring_cqe & cqe, const kernel_timestamp::ClockOffset & offset) noexcept
+{
+  if (!(cqe.flags & IORING_CQE_F_MORE)) {
+    bus.receiving = false;
+  }
+  if (!(cqe.flags & IORING_CQE_F_BUFFER)) {
+    return;
+  }
+
+  uint16_t id = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+  const char * data = rxBuffers[id].data;
+  const auto * out = reinterpret_cast<const struct io_uring_recvmsg_out *>(data);
+  const char * control = data + sizeof(*out) + rxMsg.msg_namelen;
+  const char * payload = control + rxMsg.msg_controllen;
+
+  if (cqe.res > 0 and out->payloadlen == sizeof(struct can_frame) and !(out->flags & MSG_TRUNC)) {
+    CanFrame canFrame;
+    // CanFrame starts with a struct can_frame
+    std::memcpy(static_cast<void *>(&canFrame), payload, sizeof(struct can_frame));
+
+    if (isReply(canFrame)) {
+      struct msghdr msg = {};
+      msg.msg_control = const_cast<char *>(control);
+      msg.msg_controllen = out->controllen;
+      canFrame.timestamp = kernel_timestamp::fromControl(msg, offset);
+
+      // the oldest frame gives way when the bus isn't read
+      if (bus.receivedN == bus.received.size()) {
+        bus.receivedHead = (bus.receivedHead + 1) % bus.received.size();
+        bus.receivedN--;
+        dropped++;
+      }
+      bus.received[(bus.receivedHead + bus.receivedN) % bus.received.size()] = canFrame;
+      bus.receivedN++;
+    } else if (isError(canFrame)) {
+      bus.socket.collectError(canFrame);
+      bus.countErrorFrame();
+    }
+  }
+
+  recycle(id);
+}
+
+void UringBusGroup::recycle(uint16_t bufferId) noexcept
+{
+  if (bufferId < RX_BUFFERS and !recycled[bufferId]) {
+    recycled.set(bufferId);
+    recycledN++;
+  }
+}
+
+void UringBusGroup::provideRecycled() noexcept
+{
+  // a run of consecutive buffers per entry, the runs finding no free
+  // entry stay recycled and go with a later submission
+  size_t first = 0;
+  while (recycledN > 0 and first < RX_BUFFERS) {
+    if (!recycled[first]) {
+      first++;
+      continue;
+    }
+    size_t n = 1;
+    while (first + n < RX_BUFFERS and recycled[first + n]) {
+      n++;
+    }
+
+    struct io_uring_sqe * sqe = nextSqe();
+    if (sqe == nullptr) {
+      return;
+    }
+
+    // the classic provided buffers, the ring mapped ones turned out to be
+    // refused by some kernels which serve these fine
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = int(n);
+    sqe->addr = reinterpret_cast<uint64_t>(rxBuffers[first].data);
+    sqe->len = sizeof(RxBuffer::data);
+    sqe->off = first;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+    sqe->user_data = PROVIDE_TAG | first << 16 | n;
+
+    for (size_t k = first; k < first + n; k++) {
+      recycled.reset(k);
+    }
+    recycledN -= n;
+    first += n;
+  }
+}
+
+/************************************ Bus ************************************/
+
+UringBusGroup::Bus::Bus(UringBusGroup & group, size_t index, const std::string & canName)
+  : group(group)
+  , index(index)
+  , socket(canName)
+{ }
+
+UringBusGroup::Status UringBusGroup::Bus::write(const CanFrame & canFrame)
+{
+  return writeBatch(&canFrame, 1) == 1 ? Status::SUCCESS : Status::FAIL;
+}
+
+UringBusGroup::Status UringBusGroup::Bus::writeUrgent(const CanFrame & canFrame)
+{
+  // submitted right away, even within a cycle
+  if (fd == -1) {
+    return Status::FAIL;
+  }
+  group.supersede(*this, canFrame.canId);
+  if (!group.queueSend(*this, canFrame) or group.submit() < 0) {
+    countWriteFailures(&canFrame, 1);
+    return Status::FAIL;
+  }
+  if (deferred) {
+    awaitReply(canFrame.canId); // answered in place of the superseded command
+  }
+  countSent(&canFrame, 1);
+  return Status::SUCCESS;
+}
+
+std::optional<UringBusGroup::CanFrame> UringBusGroup::Bus::read()
+{
+  CanFrame canFrame;
+  if (readBatch(&canFrame, 1) == 1) {
+    return canFrame;
+  }
+  return {};
+}
+
+size_t UringBusGroup::Bus::writeBatch(const CanFrame * canFrames, size_t count)
+{
+  if (fd == -1) {
+    return 0;
+  }
+
+  size_t queued = 0;
+  while (queued < count and group.queueSend(*this, canFrames[queued])) {
+    queued++;
+  }
+
+  if (!deferred and group.submit() < 0) {
+    queued = 0;
+  } else if (deferred) {
+    for (size_t i = 0; i < queued; i++) {
+      awaitReply(canFrames[i].canId);
+    }
+  }
+  countSent(canFrames, queued);
+  countWriteFailures(canFrames + queued, count - queued);
+  return queued;
+}
+
+size_t UringBusGroup::Bus::readBatch(CanFrame * canFrames, size_t count)
+{
+  // no syscall, the frames are already in the completion queue
+  group.reap();
+
+  size_t n = std::min(count, receivedN);
+  for (size_t i = 0; i < n; i++) {
+    canFrames[i] = received[receivedHead];
+    receivedHead = (receivedHead + 1) % received.size();
+  }
+  receivedN -= n;
+  countReceived(n);
+  return n;
+}
+
+bool UringBusGroup::Bus::wait(std::chrono::microseconds timeout)
+{
+  auto deadline = CanFrame::Clock::now() + timeout;
+  while (true) {
+    group.reap();
+    if (receivedN > 0) {
+      return true;
+    } else if (fd == -1 or CanFrame::Clock::now() >= deadline) {
+      return false;
+    }
+    group.waitCompletions(deadline);
+  }
+}
+
+void UringBusGroup::Bus::attachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::attachMotor(canId, masterCanId);
+  socket.attachMotor(canId, masterCanId);
+}
+
+void UringBusGroup::Bus::detachMotor(uint8_t canId, uint8_t masterCanId) noexcept
+{
+  BasicTransport::detachMotor(canId, masterCanId);
+  socket.detachMotor(canId, masterCanId);
+}
+
+void UringBusGroup::Bus::bitrate(uint32_t bitsPerSecond) noexcept
+{
+  socket.bitrate(bitsPerSecond);
+}
+
+kot_motor::transport::BusLoad UringBusGroup::Bus::busLoad() const noexcept
+{
+  return socket.busLoad();
+}
+
+std::chrono::nanoseconds UringBusGroup::Bus::frameTime() const noexcept
+{
+  return socket.frameTime();
+}
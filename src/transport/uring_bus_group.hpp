@@ -0,0 +1,165 @@
+#ifndef URING_BUS_GROUP_HPP
+#define URING_BUS_GROUP_HPP
+
+#include <array>
+#include <bitset>
+#include <memory>
+#include <string>
+#include <vector>
+#include <linux/io_uring.h>
+#include "basic_transport.hpp"
+#include "socketcan_transport.hpp"
+#include "kernel_timestamp.hpp"
+
+namespace kot_motor::transport {
+
+// io_uring alternative to BusGroup, the same cycle API on one ring for
+// all the sockets. A multishot recvmsg stays armed on every socket with
+// a shared pool of provided buffers, so the received frames are reaped
+// from the completion queue without syscalls. The commands queued between
+// beginCycle() and send() go out on all the buses by a single
+// io_uring_enter, and collect() sleeps in io_uring_enter until the
+// replies come or the timeout expires, no busy-polling.
+// Outside of a cycle every write is submitted right away.
+// Requires Linux 6.0 (multishot recvmsg).
+class UringBusGroup {
+public:
+  using Status = BasicTransport::Status;
+  using CanFrame = BasicTransport::CanFrame;
+
+  // submission entries and frames in flight, for all the buses together
+  static constexpr unsigned QUEUE_DEPTH = 256;
+  // provided receive buffers shared by the buses
+  static constexpr unsigned RX_BUFFERS = 256;
+  // received frames kept per bus until read
+  static constexpr size_t RX_QUEUE_SIZE = 256;
+
+public:
+  UringBusGroup(const std::vector<std::string> & canNames);
+  UringBusGroup(const UringBusGroup &) = delete;
+  UringBusGroup & operator=(const UringBusGroup &) = delete;
+  ~UringBusGroup();
+
+  Status open();
+  Status close();
+
+  size_t size() const noexcept;
+  BasicTransport & bus(size_t i);
+  SocketCanTransport & socket(size_t i);
+
+  // Cycle
+  void beginCycle() noexcept;
+  Status send();
+  Status collect(std::chrono::microseconds timeout);
+  Status cycle(std::chrono::microseconds timeout);
+
+  // Writes the kernel failed after they had been submitted
+  uint64_t sendFailures() const noexcept;
+  // Received frames lost because their bus wasn't read in time
+  uint64_t droppedFrames() const noexcept;
+
+private:
+  class Bus : public BasicTransport {
+  public:
+    Bus(UringBusGroup & group, size_t index, const std::string & canName);
+
+    Status write(const CanFrame & canFrame) override;
+    Status writeUrgent(const CanFrame & canFrame) override;
+    std::optional<CanFrame> read() override;
+    size_t writeBatch(const CanFrame * canFrames, size_t count) override;
+    size_t readBatch(CanFrame * canFrames, size_t count) override;
+    bool wait(std::chrono::microseconds timeout) override;
+
+    void attachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+    void detachMotor(uint8_t canId, uint8_t masterCanId) noexcept override;
+
+    void bitrate(uint32_t bitsPerSecond) noexcept override;
+    BusLoad busLoad() const noexcept override;
+    std::chrono::nanoseconds frameTime() const noexcept override;
+
+    using BasicTransport::countErrorFrame; // the frames are taken by the group
+
+    UringBusGroup & group;
+    const size_t index;
+    SocketCanTransport socket;
+    int fd = -1;
+    bool deferred = false;
+    bool receiving = false; // the multishot recvmsg is armed
+
+    using BasicTransport::beginAwaiting; // the replies are awaited by the group
+    using BasicTransport::awaitReply;
+    using BasicTransport::collectAnswers;
+    using BasicTransport::awaitedReplies;
+
+    // frames reaped from the completion queue, read by the bus owner
+    std::array<CanFrame, RX_QUEUE_SIZE> received;
+    size_t receivedHead = 0;
+    size_t receivedN = 0;
+  };
+
+  // a provided buffer, the multishot recvmsg fills it with a header,
+  // the control messages and the frame one after another
+  struct RxBuffer {
+    alignas(16) char data[sizeof(struct io_uring_recvmsg_out) +
+                          sizeof(kernel_timestamp::ControlBuffer) +
+                          sizeof(struct can_frame)];
+  };
+  // consecutive buffers are provided by one entry, so they have no gaps
+  static_assert(sizeof(RxBuffer) == sizeof(RxBuffer::data));
+
+private:
+  Status setupRing();
+  void teardownRing() noexcept;
+
+  struct io_uring_sqe * nextSqe() noexcept;
+  bool queueSend(const Bus & bus, const CanFrame & canFrame) noexcept;
+  void supersede(const Bus & bus, uint32_t canId) noexcept;
+  bool queueReceive(Bus & bus) noexcept;
+  int submit() noexcept;
+  void waitCompletions(CanFrame::Clock::time_point deadline) noexcept;
+  void reap() noexcept;
+  void onReceive(Bus & bus, const struct io_uring_cqe & cqe, const kernel_timestamp::ClockOffset & offset) noexcept;
+  void recycle(uint16_t bufferId) noexcept;
+  void provideRecycled() noexcept;
+
+private:
+  std::vector<std::unique_ptr<Bus>> buses;
+
+  int ringFd = -1;
+  void * rings = nullptr;
+  size_t ringsSize = 0;
+  struct io_uring_sqe * sqes = nullptr;
+  size_t sqesSize = 0;
+
+  unsigned * sqHead = nullptr;
+  unsigned * sqTail = nullptr;
+  unsigned * sqArray = nullptr;
+  unsigned sqMask = 0;
+  unsigned sqEntries = 0;
+  unsigned toSubmit = 0;
+
+  unsigned * cqHead = nullptr;
+  unsigned * cqTail = nullptr;
+  struct io_uring_cqe * cqes = nullptr;
+  unsigned cqMask = 0;
+
+  // provided buffers, handed back to the kernel once copied out,
+  // the consecutive ones by a single entry. The recycled ones wait in
+  // the set until an entry is free for them.
+  std::unique_ptr<RxBuffer[]> rxBuffers;
+  std::bitset<RX_BUFFERS> recycled;
+  size_t recycledN = 0;
+  struct msghdr rxMsg = {}; // layout template of the multishot recvmsg
+
+  // the frames being sent stay here until their completion
+  std::unique_ptr<CanFrame[]> txSlots;
+  std::array<uint16_t, QUEUE_DEPTH> freeSlots;
+  size_t freeSlotsN = 0;
+
+  uint64_t failures = 0;
+  uint64_t dropped = 0;
+};
+
+} // namespace kot_motor::transport
+
+#endif // URING_BUS_GROUP_HPP
@@ -0,0 +1,22 @@
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <iostream>
+
+// A failed check is reported and the test goes on, main() returns
+// the outcome of all of them
+inline int & failedChecks()
+{
+  static int failed = 0;
+  return failed;
+}
+
+#define CHECK(condition)                                                     \
+  do {                                                                       \
+    if (!(condition)) {                                                      \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": " #condition "\n";      \
+      failedChecks()++;                                                      \
+    }                                                                        \
+  } while (false)
+
+#endif // CHECK_HPP
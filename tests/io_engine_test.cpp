@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <kot_motor/kot_motor.hpp>
+#include "check.hpp"
+
+using namespace kot_motor;
+using namespace std::chrono_literals;
+using CanFrame = BasicTransport::CanFrame;
+
+namespace {
+
+// The frames in the order they reach the wire, read once the engine stopped
+class WireTransport : public BasicTransport {
+public:
+  Status write(const CanFrame & canFrame) override
+  {
+    wire.push_back(canFrame);
+    written++;
+    return Status::SUCCESS;
+  }
+
+  Status writeUrgent(const CanFrame & canFrame) override
+  {
+    return write(canFrame);
+  }
+
+  std::optional<CanFrame> read() override
+  {
+    return {};
+  }
+
+  bool wait(std::chrono::microseconds) override
+  {
+    std::this_thread::yield();
+    return false;
+  }
+
+public:
+  std::vector<CanFrame> wire;
+  std::atomic<size_t> written{0};
+};
+
+CanFrame modeFrame(uint8_t canId, uint8_t mode)
+{
+  uint8_t data[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, mode};
+  return CanFrame(canId, data);
+}
+
+CanFrame command(uint8_t canId, uint8_t value)
+{
+  uint8_t data[8] = {value, 0, 0, 0, 0, 0, 0, 0};
+  return CanFrame(canId, data);
+}
+
+bool sameFrame(const CanFrame & a, const CanFrame & b)
+{
+  return a.canId == b.canId and std::equal(a.data, a.data + 8, b.data);
+}
+
+// runs the engine over the frames queued before its start
+void drive(IoEngine & engine, WireTransport & bus, size_t expected)
+{
+  engine.start();
+  auto deadline = std::chrono::steady_clock::now() + 1s;
+  while (bus.written.load() < expected and std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  engine.stop();
+}
+
+// a mode frame queued before an urgent release goes out ahead of it,
+// even past a full batch of other commands
+void earlierModeFrameGoesFirst()
+{
+  WireTransport bus;
+  IoEngine engine(bus);
+  for (size_t i = 0; i < IoEngine::BATCH_SIZE; i++) {
+    CHECK(engine.write(command(2, i)) == BasicTransport::Status::SUCCESS);
+  }
+  CHECK(engine.write(modeFrame(1, 0xFC)) == BasicTransport::Status::SUCCESS);
+  CHECK(engine.writeUrgent(command(1, 0)) == BasicTransport::Status::SUCCESS);
+
+  drive(engine, bus, IoEngine::BATCH_SIZE + 2);
+  CHECK(bus.wire.size() == IoEngine::BATCH_SIZE + 2);
+  CHECK(bus.wire.size() >= 2 and sameFrame(bus.wire[bus.wire.size() - 2], modeFrame(1, 0xFC)));
+  CHECK(bus.wire.size() >= 2 and sameFrame(bus.wire.back(), command(1, 0)));
+}
+
+// a mode frame queued after an urgent release goes out after it, and a
+// regular command before it is superseded
+void laterModeFrameGoesAfter()
+{
+  WireTransport bus;
+  IoEngine engine(bus);
+  CHECK(engine.write(command(1, 7)) == BasicTransport::Status::SUCCESS);
+  CHECK(engine.writeUrgent(command(1, 0)) == BasicTransport::Status::SUCCESS);
+  CHECK(engine.write(modeFrame(1, 0xFC)) == BasicTransport::Status::SUCCESS);
+
+  drive(engine, bus, 2);
+  CHECK(bus.wire.size() == 2);
+  CHECK(bus.wire.size() == 2 and sameFrame(bus.wire[0], command(1, 0)));
+  CHECK(bus.wire.size() == 2 and sameFrame(bus.wire[1], modeFrame(1, 0xFC)));
+}
+
+} // namespace
+
+int main()
+{
+  earlierModeFrameGoesFirst();
+  laterModeFrameGoesAfter();
+  return failedChecks() == 0 ? 0 : 1;
+}
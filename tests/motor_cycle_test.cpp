@@ -0,0 +1,54 @@
+#include <chrono>
+#include <kot_motor/kot_motor.hpp>
+#include "check.hpp"
+
+using namespace kot_motor;
+using namespace std::chrono_literals;
+
+namespace {
+
+// the deadline of a cycle is on the simulated time line, a missing
+// reply costs the timeout of simulated time and no more
+void missingRepliesCostTheTimeout()
+{
+  SimulatedMotorTransport::Options options;
+  options.dropRate = 1.0f;
+  SimulatedMotorTransport bus(options);
+  bus.addMotor(1, 0, config::default_motor.motorHwLimits);
+  Motor motor(bus, 1, 0, config::default_motor);
+  MotorCycle cycle(bus);
+  CHECK(cycle.add(motor));
+
+  auto start = bus.now();
+  for (int i = 0; i < 10; i++) {
+    CHECK(cycle.run(1ms) == BasicTransport::Status::FAIL);
+    CHECK(cycle.status(0) == MotorCycle::ReplyStatus::MISSING);
+  }
+  CHECK(bus.now() - start <= 10ms);
+}
+
+// a reply within the timeout ends the cycle at the reply
+void repliesEndTheCycle()
+{
+  SimulatedMotorTransport::Options options;
+  options.latency = 200us;
+  SimulatedMotorTransport bus(options);
+  bus.addMotor(1, 0, config::default_motor.motorHwLimits);
+  Motor motor(bus, 1, 0, config::default_motor);
+  MotorCycle cycle(bus);
+  CHECK(cycle.add(motor));
+
+  auto start = bus.now();
+  CHECK(cycle.run(1ms) == BasicTransport::Status::SUCCESS);
+  CHECK(cycle.status(0) == MotorCycle::ReplyStatus::FRESH);
+  CHECK(bus.now() - start < 1ms);
+}
+
+} // namespace
+
+int main()
+{
+  missingRepliesCostTheTimeout();
+  repliesEndTheCycle();
+  return failedChecks() == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include <vector>
+#include <kot_motor/kot_motor.hpp>
+#include "check.hpp"
+
+using namespace kot_motor;
+using CanFrame = BasicTransport::CanFrame;
+
+namespace {
+
+// The lane of every frame written, urgent or not
+class LaneTransport : public BasicTransport {
+public:
+  Status write(const CanFrame & canFrame) override
+  {
+    lanes.push_back({canFrame.canId, false});
+    return Status::SUCCESS;
+  }
+
+  Status writeUrgent(const CanFrame & canFrame) override
+  {
+    lanes.push_back({canFrame.canId, true});
+    return Status::SUCCESS;
+  }
+
+  std::optional<CanFrame> read() override
+  {
+    return {};
+  }
+
+public:
+  struct Lane {
+    uint32_t canId;
+    bool urgent;
+  };
+  std::vector<Lane> lanes;
+};
+
+// only the command taking the motor limp is urgent, the default and the
+// idle commands of a limp motor queue with the others
+void onlyGoingLimpIsUrgent()
+{
+  LaneTransport bus;
+  Motor motor(bus, 1, 0, config::default_motor);
+
+  CHECK(!motor.isReleasing());
+  motor.sendToMotor(); // default
+  motor.stiffness(20);
+  motor.damper(1);
+  motor.sendToMotor(); // holding
+  motor.sendToMotor();
+  motor.stiffness(0);
+  motor.damper(0);
+  CHECK(motor.isReleasing());
+  motor.sendToMotor(); // going limp
+  CHECK(!motor.isReleasing());
+  motor.sendToMotor(); // idle
+  motor.position(1);
+  motor.sendToMotor(); // idle, elsewhere
+
+  std::vector<bool> expected = {false, false, false, true, false, false};
+  CHECK(bus.lanes.size() == expected.size());
+  for (size_t i = 0; i < bus.lanes.size() and i < expected.size(); i++) {
+    CHECK(bus.lanes[i].urgent == expected[i]);
+  }
+}
+
+// a cycle over motors idle, holding and going limp sends only the one
+// going limp by the urgent lane
+void cycleSendsOnlyTheOneGoingLimpUrgently()
+{
+  LaneTransport bus;
+  Motor idle(bus, 1, 0, config::default_motor);
+  Motor holding(bus, 2, 0, config::default_motor);
+  Motor releasing(bus, 3, 0, config::default_motor);
+  MotorCycle cycle(bus);
+  CHECK(cycle.add(idle) and cycle.add(holding) and cycle.add(releasing));
+
+  holding.stiffness(20);
+  releasing.torque(1);
+  CHECK(cycle.send() == BasicTransport::Status::SUCCESS);
+  releasing.torque(0);
+  bus.lanes.clear();
+  CHECK(cycle.send() == BasicTransport::Status::SUCCESS);
+
+  CHECK(bus.lanes.size() == 3);
+  for (auto && lane : bus.lanes) {
+    CHECK(lane.urgent == (lane.canId == 3));
+  }
+}
+
+} // namespace
+
+int main()
+{
+  onlyGoingLimpIsUrgent();
+  cycleSendsOnlyTheOneGoingLimpUrgently();
+  return failedChecks() == 0 ? 0 : 1;
+}